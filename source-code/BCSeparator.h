@@ -87,7 +87,7 @@ namespace op {
                 for(const auto& next_v : as::graph::neighbours(current_v, graph.g)) {
                     if(contains(cc, next_v)) { continue; }
 
-                    const auto edge = boost::edge(current_v, next_v, graph.g).first;
+                    const auto edge = graph.edge(current_v, next_v);
                     const auto edge_id = graph.g[edge].id;
 
                     if(this->template getValue(x[edge_id]) > .5) {
@@ -99,7 +99,7 @@ namespace op {
                 }
 
                 if(prev_v == current_v) {
-                    assert(this->template getValue(x[graph.g[boost::edge(current_v, starting_v, graph.g).first].id]) > .5);
+                    assert(this->template getValue(x[graph.g[graph.edge(current_v, starting_v)].id]) > .5);
                     current_v = starting_v;
                 }
             } while(current_v != starting_v);
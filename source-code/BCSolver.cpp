@@ -18,6 +18,10 @@ namespace op {
         using as::containers::contains;
         using as::and_die;
 
+        if(!graph.has_materialised_edges()) {
+            std::cerr << error << "The branch-and-cut solver needs a graph with materialised edges." << and_die();
+        }
+
         IloEnv env;
         IloModel model(env);
 
@@ -33,7 +37,7 @@ namespace op {
 
             x[edge_id] = IloNumVar(env, 0, 1, IloNumVar::Bool);
 
-            expr += static_cast<double>(graph.g[edge].travel_time) * x[edge_id];
+            expr += static_cast<double>(graph.travel_time(boost::source(edge, graph.g), boost::target(edge, graph.g))) * x[edge_id];
         }
 
         model.add(IloRange(env, 0, expr, graph.max_travel_time));
@@ -100,7 +104,7 @@ namespace op {
                         // Do not go back on the same vertex you came from.
                         if(contains(sol_vertices, vertex)) { continue; }
 
-                        const auto edge = boost::edge(current_vertex, vertex, graph.g).first;
+                        const auto edge = graph.edge(current_vertex, vertex);
                         const auto edge_id = graph.g[edge].id;
                         if(cplex.getValue(x[edge_id]) > 0) {
                             sol_vertices.push_back(vertex);
@@ -110,7 +114,7 @@ namespace op {
                     }
 
                     if(prev_vertex == current_vertex) {
-                        auto back_edge = boost::edge(current_vertex, 0u, graph.g).first;
+                        auto back_edge = graph.edge(current_vertex, 0u);
 
                         assert(cplex.getValue(x[graph.g[back_edge].id]));
 
@@ -0,0 +1,156 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#ifndef OP_BUFFER_H
+#define OP_BUFFER_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "MappedFile.h"
+
+namespace op {
+    /**
+     * A read-mostly array of trivially copyable elements, which either owns
+     * its elements, or points into a memory-mapped file. In the latter case,
+     * copies of the buffer share the mapping (and keep it alive), and the
+     * elements cannot be modified.
+     *
+     * @tparam T The element type.
+     */
+    template<typename T>
+    class Buffer {
+        static_assert(std::is_trivially_copyable<T>::value, "Buffer elements must be trivially copyable");
+
+        /**
+         * Elements, if the buffer owns them.
+         */
+        std::vector<T> owned;
+
+        /**
+         * Mapped file, if the buffer points into it.
+         */
+        std::shared_ptr<const MappedFile> mapping;
+
+        /**
+         * Pointer to the first element (either in owned, or in mapping).
+         */
+        const T* first;
+
+        /**
+         * Number of elements.
+         */
+        std::size_t count;
+
+        /**
+         * Makes first point to the right memory, after owned or mapping changed.
+         */
+        void repoint(const Buffer& source) {
+            first = mapping ? source.first : owned.data();
+        }
+
+    public:
+
+        /**
+         * Builds an empty buffer.
+         */
+        Buffer() : first{nullptr}, count{0u} {}
+
+        /**
+         * Builds a buffer which owns its elements.
+         *
+         * @param elements  The elements.
+         */
+        explicit Buffer(std::vector<T> elements) :
+            owned{std::move(elements)}, first{owned.data()}, count{owned.size()} {}
+
+        /**
+         * Builds a buffer which owns n copies of an element.
+         *
+         * @param n     Number of elements.
+         * @param value The element.
+         */
+        Buffer(std::size_t n, const T& value) : Buffer(std::vector<T>(n, value)) {}
+
+        /**
+         * Builds a buffer pointing into a memory-mapped file. The elements
+         * must be correctly aligned and lie inside the mapped memory.
+         *
+         * @param mapping   The mapped file.
+         * @param offset    Offset, in bytes, of the first element in the file.
+         * @param n         Number of elements.
+         */
+        Buffer(std::shared_ptr<const MappedFile> mapping, std::size_t offset, std::size_t n) :
+            mapping{std::move(mapping)},
+            first{reinterpret_cast<const T*>(this->mapping->data() + offset)},
+            count{n}
+        {
+            assert(offset + n * sizeof(T) <= this->mapping->size());
+            assert(reinterpret_cast<std::uintptr_t>(first) % alignof(T) == 0u);
+        }
+
+        Buffer(const Buffer& other) : owned{other.owned}, mapping{other.mapping}, count{other.count} { repoint(other); }
+        Buffer(Buffer&& other) noexcept : owned{std::move(other.owned)}, mapping{std::move(other.mapping)}, count{other.count} { repoint(other); }
+
+        Buffer& operator=(const Buffer& other) {
+            if(this != &other) {
+                owned = other.owned;
+                mapping = other.mapping;
+                count = other.count;
+                repoint(other);
+            }
+            return *this;
+        }
+
+        Buffer& operator=(Buffer&& other) noexcept {
+            if(this != &other) {
+                owned = std::move(other.owned);
+                mapping = std::move(other.mapping);
+                count = other.count;
+                repoint(other);
+            }
+            return *this;
+        }
+
+        /**
+         * Tells whether the buffer points into a memory-mapped file.
+         */
+        bool is_mapped() const { return static_cast<bool>(mapping); }
+
+        /**
+         * Pointer to the first element.
+         */
+        const T* data() const { return first; }
+
+        /**
+         * Pointer to the first element, for writing. The buffer must own its elements.
+         */
+        T* mutable_data() { assert(!is_mapped()); return owned.data(); }
+
+        /**
+         * Number of elements.
+         */
+        std::size_t size() const { return count; }
+
+        /**
+         * Tells whether the buffer has no elements.
+         */
+        bool empty() const { return count == 0u; }
+
+        /**
+         * Memory used by the elements, in bytes.
+         */
+        std::size_t size_in_bytes() const { return count * sizeof(T); }
+
+        const T& operator[](std::size_t i) const { assert(i < count); return first[i]; }
+        const T* begin() const { return first; }
+        const T* end() const { return first + count; }
+        const T& back() const { assert(count > 0u); return first[count - 1u]; }
+    };
+}
+
+#endif //OP_BUFFER_H
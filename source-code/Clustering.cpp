@@ -19,7 +19,7 @@ namespace op {
         assert(std::all_of(
            clusters.begin(),
            clusters.end(),
-           [] (const std::vector<BoostVertex>& cluster) -> bool {
+           [] (const VertexList& cluster) -> bool {
                return cluster.size() > 1u;
            }
         ));
@@ -33,12 +33,12 @@ namespace op {
 
         for(const auto& vertex : as::graph::vertices(graph->g)) {
             if(graph->g[vertex].depot) { continue; }
-            if(!graph->g[vertex].reachable) { continue; }
+            if(!graph->is_reachable(vertex)) { continue; }
 
             if(std::none_of(
                clusters.begin(),
                clusters.end(),
-               [&vertex] (const std::vector<BoostVertex>& cluster) -> bool {
+               [&vertex] (const VertexList& cluster) -> bool {
                    return contains(cluster, vertex);
                }
             )) {
@@ -58,11 +58,11 @@ namespace op {
             float y_tot = 0.0f;
 
             for(const auto& vertex : clusters[id]) {
-                auto vprize = graph->g[vertex].prize;
+                auto vprize = graph->prize(vertex);
 
                 prize += vprize;
-                x_tot += graph->g[vertex].x * vprize;
-                y_tot += graph->g[vertex].y * vprize;
+                x_tot += graph->vertex_arrays.xs[vertex] * vprize;
+                y_tot += graph->vertex_arrays.ys[vertex] * vprize;
             }
 
             centres[id] = BoostPoint(x_tot / prize, y_tot / prize);
@@ -16,7 +16,7 @@ namespace op {
      * A clustering of the vertices, i.e. a set of subsets V which are
      * mutually disjoint (but whose union does not necessarily cover V.
      */
-    using VertexClustering = std::vector<std::vector<BoostVertex>>;
+    using VertexClustering = std::vector<VertexList>;
 
     /**
      * This class represents a clustering of (some of) the
@@ -54,7 +54,7 @@ namespace op {
          * Vertices which do not belong to any cluster, besides
          * the depot and the unreachable vertices.
          */
-        std::vector<BoostVertex> noise;
+        VertexList noise;
 
         /**
          * Empty constructor.
@@ -0,0 +1,201 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#include "DistanceKernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define OP_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace op {
+    namespace kernels {
+        namespace {
+            enum class InstructionSet { Scalar, SSE41, AVX2 };
+
+            InstructionSet detect_instruction_set() {
+#ifdef OP_X86_KERNELS
+                __builtin_cpu_init();
+                if(__builtin_cpu_supports("avx2")) { return InstructionSet::AVX2; }
+                if(__builtin_cpu_supports("sse4.1")) { return InstructionSet::SSE41; }
+#endif
+                return InstructionSet::Scalar;
+            }
+
+            InstructionSet available_instruction_set() {
+                static const InstructionSet isa = detect_instruction_set();
+                return isa;
+            }
+
+            // The GEO metric needs trigonometric functions, which have no
+            // vector instructions: it always uses the scalar loop.
+            bool is_vectorisable(DistanceMetric metric) {
+                return metric == DistanceMetric::Euclidean ||
+                       metric == DistanceMetric::Euc2D ||
+                       metric == DistanceMetric::Ceil2D ||
+                       metric == DistanceMetric::Att;
+            }
+
+#ifdef OP_X86_KERNELS
+            // Applies the metric to the squared euclidean distances d2.
+            __attribute__((target("sse4.1")))
+            __m128d apply_metric_sse(DistanceMetric metric, __m128d d2) {
+                switch(metric) {
+                    case DistanceMetric::Euc2D:
+                        return _mm_floor_pd(_mm_add_pd(_mm_sqrt_pd(d2), _mm_set1_pd(0.5)));
+                    case DistanceMetric::Ceil2D:
+                        return _mm_ceil_pd(_mm_sqrt_pd(d2));
+                    case DistanceMetric::Att: {
+                        const auto r = _mm_sqrt_pd(_mm_div_pd(d2, _mm_set1_pd(10.0)));
+                        const auto t = _mm_floor_pd(_mm_add_pd(r, _mm_set1_pd(0.5)));
+                        return _mm_blendv_pd(t, _mm_add_pd(t, _mm_set1_pd(1.0)), _mm_cmplt_pd(t, r));
+                    }
+                    default:
+                        return _mm_sqrt_pd(d2);
+                }
+            }
+
+            // Processes two targets at a time. If targets is null, the targets
+            // are the first n points, otherwise they are given by their indices.
+            __attribute__((target("sse4.1")))
+            std::size_t distances_sse(DistanceMetric metric, double x, double y, const double* xs, const double* ys,
+                                      const VertexIndex* targets, std::size_t n, float* out) {
+                const auto sx = _mm_set1_pd(x), sy = _mm_set1_pd(y);
+                std::size_t k = 0u;
+
+                for(; k + 2u <= n; k += 2u) {
+                    const auto t0 = targets ? targets[k] : k;
+                    const auto t1 = targets ? targets[k + 1u] : k + 1u;
+
+                    const auto dx = _mm_sub_pd(sx, _mm_set_pd(xs[t1], xs[t0]));
+                    const auto dy = _mm_sub_pd(sy, _mm_set_pd(ys[t1], ys[t0]));
+                    const auto d2 = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+                    const auto d = _mm_cvtpd_ps(apply_metric_sse(metric, d2));
+
+                    _mm_storel_pi(reinterpret_cast<__m64*>(out + k), d);
+                }
+
+                return k;
+            }
+
+            // Applies the metric to the squared euclidean distances d2.
+            __attribute__((target("avx2")))
+            __m256d apply_metric_avx2(DistanceMetric metric, __m256d d2) {
+                switch(metric) {
+                    case DistanceMetric::Euc2D:
+                        return _mm256_floor_pd(_mm256_add_pd(_mm256_sqrt_pd(d2), _mm256_set1_pd(0.5)));
+                    case DistanceMetric::Ceil2D:
+                        return _mm256_ceil_pd(_mm256_sqrt_pd(d2));
+                    case DistanceMetric::Att: {
+                        const auto r = _mm256_sqrt_pd(_mm256_div_pd(d2, _mm256_set1_pd(10.0)));
+                        const auto t = _mm256_floor_pd(_mm256_add_pd(r, _mm256_set1_pd(0.5)));
+                        return _mm256_blendv_pd(t, _mm256_add_pd(t, _mm256_set1_pd(1.0)), _mm256_cmp_pd(t, r, _CMP_LT_OQ));
+                    }
+                    default:
+                        return _mm256_sqrt_pd(d2);
+                }
+            }
+
+            static_assert(sizeof(VertexIndex) == sizeof(std::uint16_t) || sizeof(VertexIndex) == sizeof(std::uint32_t),
+                          "Unsupported vertex index size");
+
+            // Loads four vertex indices as 32-bit integers.
+            __attribute__((target("avx2")))
+            inline __m128i load_indices_avx2(const VertexIndex* indices) {
+                if constexpr(sizeof(VertexIndex) == sizeof(std::uint16_t)) {
+                    return _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(indices)));
+                } else {
+                    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices));
+                }
+            }
+
+            // Processes four targets at a time. If targets is null, the targets
+            // are the first n points, otherwise they are given by their indices.
+            __attribute__((target("avx2")))
+            std::size_t distances_avx2(DistanceMetric metric, double x, double y, const double* xs, const double* ys,
+                                       const VertexIndex* targets, std::size_t n, float* out) {
+                const auto sx = _mm256_set1_pd(x), sy = _mm256_set1_pd(y);
+                std::size_t k = 0u;
+
+                for(; k + 4u <= n; k += 4u) {
+                    __m256d tx, ty;
+
+                    if(targets) {
+                        const auto idx = load_indices_avx2(targets + k);
+                        tx = _mm256_i32gather_pd(xs, idx, sizeof(double));
+                        ty = _mm256_i32gather_pd(ys, idx, sizeof(double));
+                    } else {
+                        tx = _mm256_loadu_pd(xs + k);
+                        ty = _mm256_loadu_pd(ys + k);
+                    }
+
+                    const auto dx = _mm256_sub_pd(sx, tx);
+                    const auto dy = _mm256_sub_pd(sy, ty);
+                    const auto d2 = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+
+                    _mm_storeu_ps(out + k, _mm256_cvtpd_ps(apply_metric_avx2(metric, d2)));
+                }
+
+                return k;
+            }
+#endif
+        }
+
+        void distances_to(DistanceMetric metric, double x, double y, const double* xs, const double* ys,
+                          const VertexIndex* targets, std::size_t n, float* out) {
+            std::size_t done = 0u;
+
+#ifdef OP_X86_KERNELS
+            if(is_vectorisable(metric)) {
+                switch(available_instruction_set()) {
+                    case InstructionSet::AVX2:
+                        done = distances_avx2(metric, x, y, xs, ys, targets, n, out);
+                        break;
+                    case InstructionSet::SSE41:
+                        done = distances_sse(metric, x, y, xs, ys, targets, n, out);
+                        break;
+                    default:
+                        break;
+                }
+            }
+#endif
+
+            for(auto k = done; k < n; ++k) {
+                out[k] = metric_distance(metric, x, y, xs[targets[k]], ys[targets[k]]);
+            }
+        }
+
+        void distances_to_range(DistanceMetric metric, double x, double y, const double* xs, const double* ys,
+                                std::size_t n, float* out) {
+            std::size_t done = 0u;
+
+#ifdef OP_X86_KERNELS
+            if(is_vectorisable(metric)) {
+                switch(available_instruction_set()) {
+                    case InstructionSet::AVX2:
+                        done = distances_avx2(metric, x, y, xs, ys, nullptr, n, out);
+                        break;
+                    case InstructionSet::SSE41:
+                        done = distances_sse(metric, x, y, xs, ys, nullptr, n, out);
+                        break;
+                    default:
+                        break;
+                }
+            }
+#endif
+
+            for(auto k = done; k < n; ++k) {
+                out[k] = metric_distance(metric, x, y, xs[k], ys[k]);
+            }
+        }
+
+        std::string instruction_set() {
+            switch(available_instruction_set()) {
+                case InstructionSet::AVX2: return "AVX2";
+                case InstructionSet::SSE41: return "SSE4.1";
+                default: return "scalar";
+            }
+        }
+    }
+}
@@ -0,0 +1,63 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#ifndef OP_DISTANCEKERNELS_H
+#define OP_DISTANCEKERNELS_H
+
+#include <cstddef>
+#include <string>
+#include "DistanceOracle.h"
+#include "GraphTypes.h"
+
+namespace op {
+    /**
+     * Batch kernels which compute the distances from one point to many
+     * points, according to a metric. On x86 processors they use AVX2 or
+     * SSE4.1 instructions when the processor supports them (detected at
+     * runtime), and a scalar loop otherwise. All implementations give
+     * exactly the same results as metric_distance(), including the TSPLIB
+     * rounding rules, because they work in double precision as it does,
+     * on coordinates stored in double precision.
+     * The GEO metric is always computed by the scalar loop.
+     */
+    namespace kernels {
+        /**
+         * Computes out[k] = distance between (x, y) and (xs[targets[k]], ys[targets[k]]),
+         * for k = 0, ..., n - 1.
+         *
+         * @param metric    The metric; it cannot be DistanceMetric::Explicit.
+         * @param x         X-coordinate of the source point.
+         * @param y         Y-coordinate of the source point.
+         * @param xs        X-coordinates of all points.
+         * @param ys        Y-coordinates of all points.
+         * @param targets   Indices of the target points.
+         * @param n         Number of target points.
+         * @param out       Output array, with space for n distances.
+         */
+        void distances_to(DistanceMetric metric, double x, double y, const double* xs, const double* ys,
+                          const VertexIndex* targets, std::size_t n, float* out);
+
+        /**
+         * Computes out[k] = distance between (x, y) and (xs[k], ys[k]),
+         * for k = 0, ..., n - 1.
+         *
+         * @param metric    The metric; it cannot be DistanceMetric::Explicit.
+         * @param x         X-coordinate of the source point.
+         * @param y         Y-coordinate of the source point.
+         * @param xs        X-coordinates of the target points.
+         * @param ys        Y-coordinates of the target points.
+         * @param n         Number of target points.
+         * @param out       Output array, with space for n distances.
+         */
+        void distances_to_range(DistanceMetric metric, double x, double y, const double* xs, const double* ys,
+                                std::size_t n, float* out);
+
+        /**
+         * Name of the instruction set used by the kernels on this processor.
+         */
+        std::string instruction_set();
+    }
+}
+
+#endif //OP_DISTANCEKERNELS_H
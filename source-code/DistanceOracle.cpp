@@ -0,0 +1,173 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#include "DistanceOracle.h"
+
+#include <as/console.h>
+#include <as/and_die.h>
+#include <cassert>
+#include <iostream>
+#include <limits>
+
+namespace op {
+    DistanceMetric metric_from_edge_weight_type(const std::string& edge_weight_type) {
+        if(edge_weight_type == "EUC_2D") { return DistanceMetric::Euc2D; }
+        if(edge_weight_type == "CEIL_2D") { return DistanceMetric::Ceil2D; }
+        if(edge_weight_type == "ATT") { return DistanceMetric::Att; }
+        if(edge_weight_type == "GEO") { return DistanceMetric::Geo; }
+        return DistanceMetric::Explicit;
+    }
+
+    std::string edge_weight_type_from_metric(DistanceMetric metric) {
+        switch(metric) {
+            case DistanceMetric::Euc2D: return "EUC_2D";
+            case DistanceMetric::Ceil2D: return "CEIL_2D";
+            case DistanceMetric::Att: return "ATT";
+            case DistanceMetric::Geo: return "GEO";
+            case DistanceMetric::Euclidean: return "EUC_2D";
+            default: return "EXPLICIT";
+        }
+    }
+
+    bool is_monotone_in_euclidean_distance(DistanceMetric metric) {
+        switch(metric) {
+            case DistanceMetric::Euclidean:
+            case DistanceMetric::Euc2D:
+            case DistanceMetric::Ceil2D:
+            case DistanceMetric::Att:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    namespace {
+        // Converts a TSPLIB DDD.MM coordinate to radians.
+        double geo_radians(double coord) {
+            const double pi = 3.141592;
+            const double deg = static_cast<int>(coord);
+            const double min = coord - deg;
+            return pi * (deg + 5.0 * min / 3.0) / 180.0;
+        }
+    }
+
+    float metric_distance(DistanceMetric metric, double x1, double y1, double x2, double y2) {
+        const double xd = x1 - x2;
+        const double yd = y1 - y2;
+
+        switch(metric) {
+            case DistanceMetric::Euclidean:
+                return static_cast<float>(std::sqrt(xd * xd + yd * yd));
+            case DistanceMetric::Euc2D:
+                return static_cast<float>(static_cast<long int>(std::sqrt(xd * xd + yd * yd) + 0.5));
+            case DistanceMetric::Ceil2D:
+                return static_cast<float>(std::ceil(std::sqrt(xd * xd + yd * yd)));
+            case DistanceMetric::Att: {
+                const double r = std::sqrt((xd * xd + yd * yd) / 10.0);
+                const double t = static_cast<long int>(r + 0.5);
+                return static_cast<float>(t < r ? t + 1.0 : t);
+            }
+            case DistanceMetric::Geo: {
+                const double earth_radius = 6378.388;
+                const double lat1 = geo_radians(x1), lon1 = geo_radians(y1);
+                const double lat2 = geo_radians(x2), lon2 = geo_radians(y2);
+                const double q1 = std::cos(lon1 - lon2);
+                const double q2 = std::cos(lat1 - lat2);
+                const double q3 = std::cos(lat1 + lat2);
+                return static_cast<float>(static_cast<long int>(
+                    earth_radius * std::acos(0.5 * ((1.0 + q1) * q2 - (1.0 - q1) * q3)) + 1.0
+                ));
+            }
+            default:
+                std::cerr << as::console::error << "Cannot compute explicit travel times from coordinates." << as::and_die();
+                return std::numeric_limits<float>::infinity();
+        }
+    }
+
+    DistanceOracle::DistanceOracle(Backend backend, DistanceMetric metric, std::vector<double> xs, std::vector<double> ys, float max_value) :
+        backend{backend},
+        metric{metric},
+        n_vertices{xs.size()},
+        storage{storage_size(backend, xs.size()), 0.0f},
+        quantised_storage{quantised_storage_size(backend, xs.size()), saturated},
+        quantum{max_value > 0.0f ? max_value / static_cast<float>(saturated - 1u) : 1.0f},
+        xs{std::move(xs)},
+        ys{std::move(ys)}
+    {
+        assert(this->xs.size() == this->ys.size());
+
+        if(needs_coordinates(backend) && metric == DistanceMetric::Explicit) {
+            std::cerr << as::console::error << "Explicit travel times cannot be computed from coordinates." << as::and_die();
+        }
+    }
+
+    DistanceOracle::DistanceOracle(Backend backend, DistanceMetric metric, Buffer<double> xs, Buffer<double> ys, Buffer<float> storage,
+                                   Buffer<std::uint16_t> quantised_storage, float quantum) :
+        backend{backend},
+        metric{metric},
+        n_vertices{xs.size()},
+        storage{std::move(storage)},
+        quantised_storage{std::move(quantised_storage)},
+        quantum{quantum},
+        xs{std::move(xs)},
+        ys{std::move(ys)}
+    {
+        assert(this->xs.size() == this->ys.size());
+        assert(this->storage.size() == storage_size(backend, n_vertices));
+        assert(this->quantised_storage.size() == quantised_storage_size(backend, n_vertices));
+    }
+
+    std::size_t DistanceOracle::quantised_storage_size(Backend backend, std::size_t n_vertices) {
+        if(backend == Backend::QuantisedTriangularMatrix) {
+            return n_vertices * (n_vertices - 1u) / 2u;
+        } else {
+            return 0u;
+        }
+    }
+
+    std::size_t DistanceOracle::storage_size(Backend backend, std::size_t n_vertices) {
+        switch(backend) {
+            case Backend::DenseMatrix:
+                return n_vertices * n_vertices;
+            case Backend::TriangularMatrix:
+                return n_vertices * (n_vertices - 1u) / 2u;
+            default:
+                return 0u;
+        }
+    }
+
+    void DistanceOracle::set(std::size_t i, std::size_t j, float tt) {
+        assert(is_materialised());
+        assert(i != j);
+
+        if(backend == Backend::QuantisedTriangularMatrix) {
+            // Travel times which do not fit are saturated, and will be computed on request.
+            const auto q = std::nearbyint(tt / quantum);
+            const auto qv = (q < static_cast<float>(saturated)) ? static_cast<std::uint16_t>(q) : saturated;
+
+            if(i > j) { std::swap(i, j); }
+            quantised_storage.mutable_data()[triangular_index(i, j)] = qv;
+            return;
+        }
+
+        float* const data = storage.mutable_data();
+
+        if(backend == Backend::DenseMatrix) {
+            data[i * n_vertices + j] = tt;
+            data[j * n_vertices + i] = tt;
+        } else {
+            if(i > j) { std::swap(i, j); }
+            data[triangular_index(i, j)] = tt;
+        }
+    }
+
+    std::string DistanceOracle::backend_name() const {
+        switch(backend) {
+            case Backend::DenseMatrix: return "dense matrix";
+            case Backend::TriangularMatrix: return "triangular matrix";
+            case Backend::QuantisedTriangularMatrix: return "quantised triangular matrix";
+            default: return "coordinates";
+        }
+    }
+}
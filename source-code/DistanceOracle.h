@@ -0,0 +1,337 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#ifndef OP_DISTANCEORACLE_H
+#define OP_DISTANCEORACLE_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Buffer.h"
+
+namespace op {
+    /**
+     * Distance function which maps vertex coordinates to travel times.
+     */
+    enum class DistanceMetric {
+        /**
+         * Travel times are given explicitly and cannot be
+         * computed from the vertex coordinates.
+         */
+        Explicit,
+
+        /**
+         * Exact (not rounded) euclidean distance.
+         */
+        Euclidean,
+
+        /**
+         * TSPLIB EUC_2D: euclidean distance rounded to the nearest integer.
+         */
+        Euc2D,
+
+        /**
+         * TSPLIB CEIL_2D: euclidean distance rounded up.
+         */
+        Ceil2D,
+
+        /**
+         * TSPLIB ATT: pseudo-euclidean distance.
+         */
+        Att,
+
+        /**
+         * TSPLIB GEO: geographical distance, with coordinates
+         * given as DDD.MM latitude and longitude.
+         */
+        Geo
+    };
+
+    /**
+     * Maps a TSPLIB EDGE_WEIGHT_TYPE specification to the
+     * corresponding metric. Unknown types are mapped to
+     * DistanceMetric::Explicit.
+     *
+     * @param edge_weight_type  The TSPLIB specification.
+     * @return                  The corresponding metric.
+     */
+    DistanceMetric metric_from_edge_weight_type(const std::string& edge_weight_type);
+
+    /**
+     * Maps a metric to the corresponding TSPLIB EDGE_WEIGHT_TYPE.
+     *
+     * @param metric    The metric.
+     * @return          The TSPLIB specification.
+     */
+    std::string edge_weight_type_from_metric(DistanceMetric metric);
+
+    /**
+     * Tells whether distances according to a metric never decrease when
+     * the euclidean distance between the coordinates increases. For such
+     * metrics, nearest neighbours can be found with spatial queries.
+     *
+     * @param metric    The metric.
+     * @return          True iff the metric is monotone in the euclidean distance.
+     */
+    bool is_monotone_in_euclidean_distance(DistanceMetric metric);
+
+    /**
+     * Computes the distance between two points, according to a metric.
+     * The metric cannot be DistanceMetric::Explicit.
+     *
+     * @param metric    The metric.
+     * @param x1        X-coordinate of the first point.
+     * @param y1        Y-coordinate of the first point.
+     * @param x2        X-coordinate of the second point.
+     * @param y2        Y-coordinate of the second point.
+     * @return          The distance.
+     */
+    float metric_distance(DistanceMetric metric, double x1, double y1, double x2, double y2);
+
+    /**
+     * Gives O(1) access to the travel time between any two vertices
+     * of the graph, without going through the boost graph (where
+     * looking up an edge costs O(degree)). Travel times can either be
+     * stored in a matrix, or computed on the fly from the coordinates.
+     */
+    struct DistanceOracle {
+        /**
+         * How travel times are stored.
+         */
+        enum class Backend {
+            /**
+             * Full n x n matrix, stored row-major.
+             */
+            DenseMatrix,
+
+            /**
+             * Packed upper-triangular matrix, without the diagonal.
+             * It uses half the memory of the dense matrix, at the
+             * price of a slightly more expensive index computation.
+             */
+            TriangularMatrix,
+
+            /**
+             * Nothing is stored: travel times are computed from
+             * the vertex coordinates at each request. Only available
+             * when the metric is not DistanceMetric::Explicit.
+             */
+            Coordinates,
+
+            /**
+             * Packed upper-triangular matrix of 16-bit quantised travel
+             * times, using half the memory of the triangular matrix.
+             * Stored travel times are approximate (see max_error()), and
+             * exact ones are computed from the coordinates when needed
+             * (see exact()). Only available when the metric is not
+             * DistanceMetric::Explicit.
+             */
+            QuantisedTriangularMatrix
+        };
+
+        /**
+         * Quantised value meaning that the travel time was too large to be
+         * represented, and must be computed from the coordinates.
+         */
+        static constexpr std::uint16_t saturated = 0xFFFFu;
+
+        /**
+         * Storage backend.
+         */
+        Backend backend;
+
+        /**
+         * Metric used to compute travel times from coordinates.
+         */
+        DistanceMetric metric;
+
+        /**
+         * Number of vertices.
+         */
+        std::size_t n_vertices;
+
+        /**
+         * Stored travel times (empty for the coordinates and quantised backends).
+         */
+        Buffer<float> storage;
+
+        /**
+         * Stored quantised travel times (only for the quantised backend).
+         */
+        Buffer<std::uint16_t> quantised_storage;
+
+        /**
+         * Travel time corresponding to one unit of the quantised values.
+         */
+        float quantum;
+
+        /**
+         * Vertex x-coordinates, used to compute travel times. They are kept in
+         * double precision, as in the instance file: rounding them to float
+         * would change some of the rounded TSPLIB distances.
+         */
+        Buffer<double> xs;
+
+        /**
+         * Vertex y-coordinates, used to compute travel times.
+         */
+        Buffer<double> ys;
+
+        /**
+         * Empty constructor.
+         */
+        DistanceOracle() = default;
+
+        /**
+         * Builds an oracle for a set of vertices. If the backend stores a matrix,
+         * it is allocated but not filled: travel times must be filled with set().
+         * Calls to set() on different pairs of vertices can run concurrently.
+         *
+         * @param backend   The storage backend.
+         * @param metric    The metric to compute travel times from coordinates.
+         * @param xs        The x-coordinates of the vertices.
+         * @param ys        The y-coordinates of the vertices.
+         * @param max_value Largest travel time which the quantised backend must
+         *                  represent; larger ones are computed from the coordinates.
+         */
+        DistanceOracle(Backend backend, DistanceMetric metric, std::vector<double> xs, std::vector<double> ys, float max_value = 0.0f);
+
+        /**
+         * Builds an oracle from already computed data, e.g. read from a cache.
+         *
+         * @param backend   The storage backend.
+         * @param metric    The metric to compute travel times from coordinates.
+         * @param xs        The x-coordinates of the vertices.
+         * @param ys        The y-coordinates of the vertices.
+         * @param storage   The stored travel times, in the layout of the backend.
+         * @param quantised_storage The stored quantised travel times, for the quantised backend.
+         * @param quantum   Travel time corresponding to one quantised unit.
+         */
+        DistanceOracle(Backend backend, DistanceMetric metric, Buffer<double> xs, Buffer<double> ys, Buffer<float> storage,
+                       Buffer<std::uint16_t> quantised_storage, float quantum);
+
+        /**
+         * Returns the travel time between two vertices.
+         *
+         * @param i First vertex.
+         * @param j Second vertex.
+         * @return  The travel time.
+         */
+        float operator()(std::size_t i, std::size_t j) const {
+            switch(backend) {
+                case Backend::DenseMatrix:
+                    return storage[i * n_vertices + j];
+                case Backend::TriangularMatrix:
+                    if(i == j) { return 0.0f; }
+                    if(i > j) { std::swap(i, j); }
+                    return storage[triangular_index(i, j)];
+                case Backend::QuantisedTriangularMatrix: {
+                    if(i == j) { return 0.0f; }
+                    if(i > j) { std::swap(i, j); }
+                    const auto q = quantised_storage[triangular_index(i, j)];
+                    if(q == saturated) { return compute(i, j); }
+                    return static_cast<float>(q) * quantum;
+                }
+                default:
+                    return compute(i, j);
+            }
+        }
+
+        /**
+         * Returns the exact travel time between two vertices. It is the
+         * same as operator(), except for the quantised backend, where it
+         * is computed from the coordinates.
+         *
+         * @param i First vertex.
+         * @param j Second vertex.
+         * @return  The travel time.
+         */
+        float exact(std::size_t i, std::size_t j) const {
+            if(backend == Backend::QuantisedTriangularMatrix) {
+                return compute(i, j);
+            }
+            return (*this)(i, j);
+        }
+
+        /**
+         * Largest difference between the travel time given by
+         * operator() and the exact one.
+         */
+        float max_error() const {
+            return backend == Backend::QuantisedTriangularMatrix ? quantum / 2.0f : 0.0f;
+        }
+
+        /**
+         * Computes the travel time between two vertices from their
+         * coordinates, irrespective of what is stored.
+         *
+         * @param i First vertex.
+         * @param j Second vertex.
+         * @return  The travel time.
+         */
+        float compute(std::size_t i, std::size_t j) const {
+            if(i == j) { return 0.0f; }
+            return metric_distance(metric, xs[i], ys[i], xs[j], ys[j]);
+        }
+
+        /**
+         * Stores the travel time between two vertices. Only
+         * available for backends which store a matrix, and
+         * when the matrix is not memory-mapped.
+         *
+         * @param i     First vertex.
+         * @param j     Second vertex.
+         * @param tt    The travel time.
+         */
+        void set(std::size_t i, std::size_t j, float tt);
+
+        /**
+         * Tells whether the backend stores a matrix which can be modified.
+         */
+        bool is_materialised() const { return backend != Backend::Coordinates; }
+
+        /**
+         * Memory used by the stored travel times, in bytes.
+         */
+        std::size_t memory_bytes() const { return storage.size_in_bytes() + quantised_storage.size_in_bytes(); }
+
+        /**
+         * Tells whether a backend needs to compute travel times from
+         * coordinates, and so cannot be used with explicit travel times.
+         */
+        static bool needs_coordinates(Backend backend) {
+            return backend == Backend::Coordinates || backend == Backend::QuantisedTriangularMatrix;
+        }
+
+        /**
+         * Number of float entries that the backend stores for a given number of vertices.
+         */
+        static std::size_t storage_size(Backend backend, std::size_t n_vertices);
+
+        /**
+         * Number of quantised entries that the backend stores for a given number of vertices.
+         */
+        static std::size_t quantised_storage_size(Backend backend, std::size_t n_vertices);
+
+        /**
+         * Human-readable name of the backend.
+         */
+        std::string backend_name() const;
+
+    private:
+
+        /**
+         * Position of the entry (i, j), i < j, in the packed
+         * upper-triangular storage.
+         */
+        std::size_t triangular_index(std::size_t i, std::size_t j) const {
+            return i * n_vertices - i * (i + 1u) / 2u + (j - i - 1u);
+        }
+    };
+}
+
+#endif //OP_DISTANCEORACLE_H
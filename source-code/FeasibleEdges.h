@@ -0,0 +1,81 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#ifndef OP_FEASIBLEEDGES_H
+#define OP_FEASIBLEEDGES_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include "Buffer.h"
+#include "GraphTypes.h"
+
+namespace op {
+    /**
+     * The edges which can appear in some feasible tour, stored as adjacency
+     * lists in compressed sparse row format: the neighbours of vertex v are
+     * targets[offsets[v]], ..., targets[offsets[v + 1] - 1], sorted by id.
+     * Each edge appears in the lists of both its endpoints.
+     */
+    struct FeasibleEdges {
+        /**
+         * Contiguous range of neighbours of a vertex.
+         */
+        struct Neighbours {
+            const VertexIndex* first;
+            const VertexIndex* last;
+
+            const VertexIndex* begin() const { return first; }
+            const VertexIndex* end() const { return last; }
+            std::size_t size() const { return static_cast<std::size_t>(last - first); }
+            bool empty() const { return first == last; }
+        };
+
+        /**
+         * Position in targets of the first neighbour of each vertex. It has one
+         * more element than the number of vertices, or none if edges are not pruned.
+         */
+        Buffer<std::size_t> offsets;
+
+        /**
+         * Neighbours of all vertices, one list after the other.
+         */
+        Buffer<VertexIndex> targets;
+
+        /**
+         * Tells whether the structure was built, i.e. whether edges were pruned.
+         */
+        bool empty() const { return offsets.empty(); }
+
+        /**
+         * Gives the neighbours of a vertex.
+         *
+         * @param v The vertex.
+         * @return  Its neighbours, sorted by id.
+         */
+        Neighbours operator[](BoostVertex v) const {
+            assert(v + 1u < offsets.size());
+            return {targets.data() + offsets[v], targets.data() + offsets[v + 1u]};
+        }
+
+        /**
+         * Tells whether there is a feasible edge between two vertices, in O(log degree) time.
+         *
+         * @param v First vertex.
+         * @param w Second vertex.
+         * @return  True iff the edge is feasible.
+         */
+        bool contains(BoostVertex v, BoostVertex w) const {
+            const auto neighbours = (*this)[v];
+            return std::binary_search(neighbours.begin(), neighbours.end(), static_cast<VertexIndex>(w));
+        }
+
+        /**
+         * Number of feasible edges.
+         */
+        std::size_t n_edges() const { return targets.size() / 2u; }
+    };
+}
+
+#endif //OP_FEASIBLEEDGES_H
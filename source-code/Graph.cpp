@@ -3,8 +3,12 @@
 //
 
 #include "Graph.h"
+#include "ParallelFor.h"
+#include "GraphCache.h"
+#include "DistanceKernels.h"
+#include "OPLibInstance.h"
+#include "HilbertCurve.h"
 
-#include <as/oplib.h>
 #include <as/and_die.h>
 #include <as/console.h>
 #include <as/graph.h>
@@ -13,103 +17,186 @@
 #include <cstdlib>
 #include <utility>
 #include <numeric>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <system_error>
+#include <unistd.h>
 
 namespace op {
     namespace fs = std::experimental::filesystem;
 
-    Graph::Graph(fs::path graph_file) : graph_file{graph_file}, opi{graph_file.string()} {
-        n_vertices = n_reachable_vertices = opi->number_of_vertices();
-        max_travel_time = opi->get_max_travel_time();
+    namespace {
+        // Dies if some vertex id does not fit in a VertexIndex.
+        void check_vertex_index_range(std::size_t n_vertices) {
+            if(n_vertices > std::size_t{std::numeric_limits<VertexIndex>::max()} + 1u) {
+                std::cerr << as::console::error << "The graph has " << n_vertices << " vertices, but vertex ids only have ";
+                std::cerr << 8u * sizeof(VertexIndex) << " bits: rebuild without OP_VERTEX_INDEX_16." << as::and_die();
+            }
+        }
+
+        // Rearranges the elements so that the i-th one of the result is the order[i]-th of the input.
+        template<typename T>
+        std::vector<T> permuted(const std::vector<T>& elements, const std::vector<BoostVertex>& order) {
+            std::vector<T> result;
+            result.reserve(order.size());
+
+            for(const auto& i : order) {
+                result.push_back(elements[i]);
+            }
+
+            return result;
+        }
+    }
+
+    Graph::Graph(fs::path graph_file, GraphOptions options) :
+        graph_file{graph_file}, options{options}
+    {
+        const auto cache_file = this->options.cache_file;
+
+        if(!cache_file.empty() && read_cache(cache_file)) {
+            return;
+        }
+
+        OPLibInstance instance(graph_file);
+
+        n_vertices = n_reachable_vertices = instance.n_vertices;
+        check_vertex_index_range(n_vertices);
+        max_travel_time = instance.max_travel_time;
+
+        // Position of each vertex of the file in the graph.
+        std::vector<BoostVertex> new_ids;
+
+        if(options.renumber_vertices) {
+            auto order = hilbert_order(instance.xs, instance.ys);
+            new_ids.resize(n_vertices);
+
+            for(auto i = 0u; i < n_vertices; ++i) {
+                new_ids[order[i]] = i;
+            }
+
+            instance.xs = permuted(instance.xs, order);
+            instance.ys = permuted(instance.ys, order);
+            instance.prizes = permuted(instance.prizes, order);
+            original_ids = Buffer<BoostVertex>(std::move(order));
+
+            std::cout << as::console::notice << "Renumbered the vertices along a Hilbert curve." << std::endl;
+        }
 
         for(auto i = 0u; i < n_vertices; ++i) {
             boost::add_vertex({
-                i,                                             // Id
-                i == 0u,                                       // Depot?
-                opi->get_distance(0, i) <= max_travel_time / 2, // Reachable?
-                opi->get_coordinates(i).x,                      // X coordinate
-                opi->get_coordinates(i).y,                      // Y coordinate
-                opi->get_prize(i)                               // Prize
+                i,                  // Id
+                i == 0u,            // Depot?
+                true,               // Reachable? (Set below.)
+                static_cast<float>(instance.xs[i]),     // X coordinate
+                static_cast<float>(instance.ys[i]),     // Y coordinate
+                instance.prizes[i]  // Prize
             }, g);
         }
 
         std::cout << as::console::notice << "Generated " << n_vertices << " vertices." << std::endl;
 
-        std::size_t edge_id = 0u;
-        for(auto i = 0u; i < n_vertices; ++i) {
-            if(!g[i].reachable) {
-                --n_reachable_vertices;
-                continue;
-            }
+        const bool explicit_weights = instance.has_explicit_weights();
 
-            for(auto j = i + 1; j < n_vertices; ++j) {
-                if(!g[j].reachable) { continue; }
+        // The coordinates are moved into the oracle, which keeps them if it needs them.
+        generate_distance_oracle(instance.metric, std::move(instance.xs), std::move(instance.ys));
+
+        // Travel times from the depot, to decide which vertices are reachable.
+        std::vector<float> depot_travel_times(n_vertices, 0.0f);
 
-                const auto tt = opi->get_distance(i, j);
+        if(explicit_weights) {
+            // Store the travel times while they are parsed. This includes the
+            // pairs with unreachable vertices, as reachability is not known yet.
+            instance.for_each_edge_weight([&] (std::size_t i, std::size_t j, float travel_time) {
+                if(!new_ids.empty()) {
+                    i = new_ids[i];
+                    j = new_ids[j];
+                }
+
+                distances.set(i, j, travel_time);
 
-                // In theory we could skip these arcs, but in practices it will
-                // give us more trouble than it saves, as then we cannot rely on
-                // the assumption that the subgraph induced by reachable vertices
-                // is complete:
-                // if(opi->get_distance(0, i) + tt + opi->get_distance(j, 0) > max_travel_time) { continue; }
+                if(i == 0u) { depot_travel_times[j] = travel_time; }
+                if(j == 0u) { depot_travel_times[i] = travel_time; }
+            });
+        } else {
+            kernels::distances_to_range(distances.metric, distances.xs[0u], distances.ys[0u],
+                distances.xs.data() + 1u, distances.ys.data() + 1u, n_vertices - 1u, depot_travel_times.data() + 1u);
+        }
 
-                boost::add_edge(
-                    i, j,
-                    {edge_id++, tt},
-                    g
-                );
+        for(auto i = 1u; i < n_vertices; ++i) {
+            if(depot_travel_times[i] > max_travel_time / 2) {
+                g[i].reachable = false;
+                --n_reachable_vertices;
             }
         }
 
-        std::cout << as::console::notice << "Generated " << edge_id << " edges." << std::endl;
+        vertex_arrays = VertexArrays(g);
+
+        if(!explicit_weights) {
+            fill_distance_oracle();
+        }
+
+        std::cout << as::console::notice << "Generated distance oracle (" << distances.backend_name() << ", ";
+        std::cout << distances.memory_bytes() / (1024.0f * 1024.0f) << " MB)." << std::endl;
 
-        generate_rtree();
+        if(!distances.is_materialised()) {
+            std::cout << as::console::notice << "Computing travel times with " << kernels::instruction_set() << " kernels." << std::endl;
+        }
+
+        generate_feasible_edges();
+        generate_edges();
+        generate_spatial_index();
         generate_proximity_map();
         set_total_prize();
 
         std::tie(min_x, max_x) = min_max_x();
         std::tie(min_y, max_y) = min_max_y();
         std::tie(min_prize, max_prize) = min_max_prize();
+
+        if(!cache_file.empty()) {
+            write_cache(cache_file);
+        }
     }
 
-    Graph::Graph(std::vector<Vertex> vertices, float max_travel_time) :
-        opi{std::nullopt},
+    Graph::Graph(std::vector<Vertex> vertices, float max_travel_time, GraphOptions options) :
+        options{options},
         max_travel_time{max_travel_time}
     {
         graph_file = "graph-" + std::to_string(std::rand());
         g = BoostGraph();
 
-        const auto eucl_dist = [] (const Vertex& v, const Vertex& w) -> float {
-            return std::sqrt(
-                std::pow(v.x - w.x, 2.0f) +
-                std::pow(v.y - w.y, 2.0f)
-            );
-        };
-
         std::cout << as::console::notice << "Received " << vertices.size() << " vertices." << std::endl;
 
+        std::vector<double> xs, ys;
+        xs.reserve(vertices.size());
+        ys.reserve(vertices.size());
+
         for(const auto& vertex : vertices) {
             boost::add_vertex(vertex, g);
+            xs.push_back(vertex.x);
+            ys.push_back(vertex.y);
         }
         n_vertices = n_reachable_vertices = boost::num_vertices(g);
+        check_vertex_index_range(n_vertices);
 
-        std::size_t edge_id = 0u;
-        for(auto i = 0u; i < n_vertices; ++i) {
-            if(!vertices[i].reachable) {
+        for(const auto& vertex : vertices) {
+            if(!vertex.reachable) {
                 --n_reachable_vertices;
-                continue;
-            }
-
-            for(auto j = i + 1; j < n_vertices; ++j) {
-                if(!vertices[j].reachable) { continue; }
-
-                const auto tt = eucl_dist(vertices[i], vertices[j]);
-                boost::add_edge(i, j, {edge_id++, tt}, g);
             }
         }
 
-        std::cout << as::console::notice << "Generated " << edge_id << " edges." << std::endl;
+        vertex_arrays = VertexArrays(g);
+
+        generate_distance_oracle(DistanceMetric::Euclidean, std::move(xs), std::move(ys));
+        fill_distance_oracle();
 
-        generate_rtree();
+        generate_feasible_edges();
+        generate_edges();
+        generate_spatial_index();
         generate_proximity_map();
         set_total_prize();
 
@@ -118,65 +205,609 @@ namespace op {
         std::tie(min_prize, max_prize) = min_max_prize();
     }
 
-    void Graph::generate_rtree() {
+    void Graph::generate_distance_oracle(DistanceMetric metric, std::vector<double> xs, std::vector<double> ys) {
+        auto backend = options.distance_storage;
+
+        if(DistanceOracle::needs_coordinates(backend) && metric == DistanceMetric::Explicit) {
+            std::cout << as::console::warning << "Travel times cannot be computed from coordinates; using a triangular matrix." << std::endl;
+            backend = options.distance_storage = DistanceOracle::Backend::TriangularMatrix;
+        }
+
+        distances = DistanceOracle(backend, metric, std::move(xs), std::move(ys), max_travel_time);
+    }
+
+    void Graph::fill_distance_oracle() {
+        if(!distances.is_materialised()) { return; }
+
+        // Number of rows handed to a thread at a time.
+        const std::size_t block_rows = 64u;
+
+        // Number of columns in a tile.
+        const std::size_t block_cols = 1024u;
+
+        parallel_for_blocks(0u, n_vertices, block_rows, options.n_threads,
+            [&] (std::size_t row_begin, std::size_t row_end) {
+                std::vector<float> tile(block_cols);
+
+                for(auto col_begin = row_begin; col_begin < n_vertices; col_begin += block_cols) {
+                    const auto col_end = std::min(n_vertices, col_begin + block_cols);
+
+                    for(auto i = row_begin; i < row_end; ++i) {
+                        if(!is_reachable(i)) { continue; }
+
+                        const auto first = std::max(i + 1u, col_begin);
+                        if(first >= col_end) { continue; }
+
+                        kernels::distances_to_range(distances.metric, distances.xs[i], distances.ys[i],
+                            distances.xs.data() + first, distances.ys.data() + first, col_end - first, tile.data());
+
+                        for(auto j = first; j < col_end; ++j) {
+                            if(!is_reachable(j)) { continue; }
+
+                            distances.set(i, j, tile[j - first]);
+                        }
+                    }
+                }
+            }
+        );
+    }
+
+    void Graph::travel_times_from(const BoostVertex& v, const VertexIndex* targets, std::size_t n, float* out) const {
+        assert(is_reachable(v));
+
+        if(distances.backend == DistanceOracle::Backend::Coordinates) {
+            kernels::distances_to(distances.metric, distances.xs[v], distances.ys[v],
+                distances.xs.data(), distances.ys.data(), targets, n, out);
+        } else {
+            for(auto k = 0u; k < n; ++k) {
+                out[k] = travel_time(v, targets[k]);
+            }
+        }
+    }
+
+    void Graph::exact_travel_times_from(const BoostVertex& v, const VertexIndex* targets, std::size_t n, float* out) const {
+        assert(is_reachable(v));
+
+        if(DistanceOracle::needs_coordinates(distances.backend)) {
+            kernels::distances_to(distances.metric, distances.xs[v], distances.ys[v],
+                distances.xs.data(), distances.ys.data(), targets, n, out);
+        } else {
+            for(auto k = 0u; k < n; ++k) {
+                out[k] = exact_travel_time(v, targets[k]);
+            }
+        }
+    }
+
+    std::vector<float> Graph::depot_shortest_path_lengths() const {
+        std::vector<float> length(n_vertices, std::numeric_limits<float>::infinity());
+        VertexList unvisited;
+        std::vector<float> times;
+
+        for(const auto& v : as::graph::vertices(g)) {
+            if(is_reachable(v)) { unvisited.push_back(v); }
+        }
+
+        length[0u] = 0.0f;
+        times.resize(unvisited.size());
+
+        while(!unvisited.empty()) {
+            const auto closest = std::min_element(unvisited.begin(), unvisited.end(),
+                [&] (const BoostVertex& v, const BoostVertex& w) { return length[v] < length[w]; }
+            );
+
+            const auto u = *closest;
+            *closest = unvisited.back();
+            unvisited.pop_back();
+
+            exact_travel_times_from(u, unvisited.data(), unvisited.size(), times.data());
+
+            for(auto k = 0u; k < unvisited.size(); ++k) {
+                auto& l = length[unvisited[k]];
+                l = std::min(l, length[u] + times[k]);
+            }
+        }
+
+        return length;
+    }
+
+    BoostEdge Graph::edge(const BoostVertex& v, const BoostVertex& w) const {
+        using namespace as::console;
+        using as::and_die;
+
+        assert(has_edge(v, w));
+
+        if(!options.materialise_edges) {
+            std::cerr << error << "Edge requested on a graph without materialised edges." << and_die();
+        }
+
+        const auto e = boost::edge(v, w, g);
+
+        if(!e.second) {
+            std::cerr << error << "Edge requested between " << v << " and " << w << ", which was pruned." << and_die();
+        }
+
+        return e.first;
+    }
+
+    void Graph::generate_feasible_edges() {
+        if(!options.prune_infeasible_edges) { return; }
+
+        // A tour using edge (i, j) goes from the depot to i, and from j back to the
+        // depot, so it cannot be shorter than these paths plus the edge.
+        const auto depot_length = depot_shortest_path_lengths();
+
+        // Sorted by id, so that the adjacency lists are sorted too.
+        VertexList reachable;
+        reachable.reserve(n_reachable_vertices);
+
+        for(const auto& v : as::graph::vertices(g)) {
+            if(is_reachable(v)) { reachable.push_back(v); }
+        }
+
+        // Allow for the rounding errors of summing the travel times in another order.
+        const auto limit = max_travel_time * (1.0f + 1e-6f);
+
+        std::vector<VertexList> rows(n_vertices);
+
+        parallel_for_blocks(0u, n_vertices, 64u, options.n_threads,
+            [&] (std::size_t block_begin, std::size_t block_end) {
+                std::vector<float> times(reachable.size());
+
+                for(auto v = block_begin; v < block_end; ++v) {
+                    if(!is_reachable(v)) { continue; }
+
+                    exact_travel_times_from(v, reachable.data(), reachable.size(), times.data());
+
+                    for(auto k = 0u; k < reachable.size(); ++k) {
+                        const auto w = reachable[k];
+
+                        // Sum the path lengths first, so that the test is symmetric in v and w.
+                        if(w != v && (depot_length[v] + depot_length[w]) + times[k] <= limit) {
+                            rows[v].push_back(w);
+                        }
+                    }
+                }
+            }
+        );
+
+        std::vector<std::size_t> offsets(n_vertices + 1u, 0u);
+
+        for(auto v = 0u; v < n_vertices; ++v) {
+            offsets[v + 1u] = offsets[v] + rows[v].size();
+        }
+
+        VertexList targets;
+        targets.reserve(offsets.back());
+
+        for(auto& row : rows) {
+            targets.insert(targets.end(), row.begin(), row.end());
+            VertexList().swap(row);
+        }
+
+        const auto all_edges = n_edges();
+
+        feasible_edges.offsets = Buffer<std::size_t>(std::move(offsets));
+        feasible_edges.targets = Buffer<VertexIndex>(std::move(targets));
+
+        std::cout << as::console::notice << "Kept " << n_edges() << " out of " << all_edges;
+        std::cout << " edges, which can appear in a feasible tour." << std::endl;
+    }
+
+    void Graph::generate_edges() {
+        if(!options.materialise_edges) {
+            std::cout << as::console::notice << "Not materialising the " << n_edges() << " edges." << std::endl;
+            return;
+        }
+
+        std::size_t edge_id = 0u;
+
+        for(auto i = 0u; i < n_vertices; ++i) {
+            if(!is_reachable(i)) { continue; }
+
+            if(has_pruned_edges()) {
+                for(const auto j : feasible_edges[i]) {
+                    if(j > i) {
+                        boost::add_edge(i, j, {edge_id++, distances(i, j)}, g);
+                    }
+                }
+
+                continue;
+            }
+
+            for(auto j = i + 1; j < n_vertices; ++j) {
+                if(!is_reachable(j)) { continue; }
+
+                boost::add_edge(i, j, {edge_id++, distances(i, j)}, g);
+            }
+        }
+
+        std::cout << as::console::notice << "Generated " << edge_id << " edges." << std::endl;
+    }
+
+    void Graph::generate_spatial_index() {
+        std::vector<BoostTreeValue> values;
+        values.reserve(n_vertices);
+
         for(const auto& vertex : as::graph::vertices(g)) {
-            BoostPoint pt(g[vertex].x, g[vertex].y);
-            rtree.insert(std::make_pair(pt, vertex));
+            values.emplace_back(BoostPoint(vertex_arrays.xs[vertex], vertex_arrays.ys[vertex]), vertex);
         }
+
+        // Use the bulk-loading (packing) constructor, which is much
+        // faster than inserting one point at a time.
+        spatial_index = SpatialIndex(values.begin(), values.end());
     }
 
     void Graph::generate_proximity_map() {
+        namespace bgi = boost::geometry::index;
+
+        n_proximity_neighbours = options.n_proximity_neighbours;
+
+        // Neighbours are reachable vertices, other than the depot.
+        VertexList candidates;
+        candidates.reserve(n_reachable_vertices);
+
         for(const auto& v : as::graph::vertices(g)) {
-            proximity_map[v] = std::vector<ProximityMapEntry>();
-            proximity_map[v].reserve(n_proximity_neighbours);
+            if(v != 0u && is_reachable(v)) {
+                candidates.push_back(v);
+            }
+        }
+
+        std::vector<std::size_t> offsets(n_vertices + 1u, 0u);
 
-            if(n_proximity_neighbours > 0u) {
-                std::size_t vertex_n = 0u;
+        for(const auto& v : as::graph::vertices(g)) {
+            std::size_t n_neighbours = 0u;
 
-                for(const auto &w : as::graph::neighbours(v, g)) {
-                    if(w == 0u) { continue; } // Skip the depot
+            if(is_reachable(v)) {
+                std::size_t n_candidates;
 
-                    auto tt = travel_time(v, w);
+                if(has_pruned_edges()) {
+                    // Neighbours which cannot be in a feasible tour are left out.
+                    const auto neighbours = feasible_edges[v];
+                    n_candidates = neighbours.size() - (!neighbours.empty() && *neighbours.begin() == 0u ? 1u : 0u);
+                } else {
+                    n_candidates = candidates.size() - (v == 0u ? 0u : 1u);
+                }
 
-                    // Add the first n_proximity_neighbours neighbours.
-                    if(vertex_n < n_proximity_neighbours) {
-                        proximity_map[v].push_back({w, tt});
-                        ++vertex_n;
-                        continue;
-                    }
+                n_neighbours = std::min(n_proximity_neighbours, n_candidates);
+            }
+
+            offsets[v + 1u] = offsets[v] + n_neighbours;
+        }
+
+        std::vector<ProximityMapEntry> entries(offsets.back());
+
+        if(is_monotone_in_euclidean_distance(distances.metric) && !has_pruned_edges()) {
+            // Index the coordinates used by the metric, which might
+            // differ from the (scaled) ones in the graph's r-tree.
+            std::vector<BoostTreeValue> points;
+            points.reserve(candidates.size());
+
+            for(const auto& w : candidates) {
+                points.emplace_back(BoostPoint(static_cast<float>(distances.xs[w]), static_cast<float>(distances.ys[w])), w);
+            }
+
+            const BoostRTree candidates_rtree(points.begin(), points.end());
+
+            parallel_for_blocks(0u, n_vertices, 256u, options.n_threads,
+                [&] (std::size_t block_begin, std::size_t block_end) {
+                    std::vector<BoostTreeValue> nearest;
 
-                    for(auto &entry : proximity_map[v]) {
-                        if(entry.travel_time > tt) {
-                            entry = {w, tt};
-                            break;
+                    for(auto v = block_begin; v < block_end; ++v) {
+                        const auto first = offsets[v], last = offsets[v + 1u];
+                        if(first == last) { continue; }
+
+                        nearest.clear();
+                        candidates_rtree.query(
+                            bgi::nearest(BoostPoint(static_cast<float>(distances.xs[v]), static_cast<float>(distances.ys[v])), last - first) &&
+                            bgi::satisfies([v] (const BoostTreeValue& value) { return value.second != v; }),
+                            std::back_inserter(nearest)
+                        );
+
+                        assert(nearest.size() == last - first);
+
+                        for(auto i = 0u; i < nearest.size(); ++i) {
+                            const auto w = static_cast<VertexIndex>(nearest[i].second);
+                            entries[first + i] = {w, travel_time(v, w)};
                         }
+
+                        // The r-tree does not return the neighbours in order and,
+                        // with rounded metrics, the order could be different anyway.
+                        std::sort(
+                            entries.begin() + static_cast<std::ptrdiff_t>(first),
+                            entries.begin() + static_cast<std::ptrdiff_t>(last),
+                            [] (const auto& w1, const auto& w2) -> bool {
+                                return w1.travel_time < w2.travel_time;
+                            }
+                        );
                     }
                 }
+            );
+        } else {
+            parallel_for_blocks(0u, n_vertices, 64u, options.n_threads,
+                [&] (std::size_t block_begin, std::size_t block_end) {
+                    std::vector<ProximityMapEntry> row;
+                    VertexList targets;
+                    std::vector<float> times(candidates.size());
+                    row.reserve(candidates.size());
+                    targets.reserve(candidates.size());
+
+                    for(auto v = block_begin; v < block_end; ++v) {
+                        const auto first = offsets[v], last = offsets[v + 1u];
+                        if(first == last) { continue; }
+
+                        row.clear();
+                        targets.clear();
+
+                        if(has_pruned_edges()) {
+                            for(const auto w : feasible_edges[v]) {
+                                if(w != 0u) { targets.push_back(w); }
+                            }
+                        } else {
+                            std::copy_if(candidates.begin(), candidates.end(), std::back_inserter(targets),
+                                [v] (const BoostVertex& w) { return w != v; });
+                        }
 
-                std::sort(
-                        proximity_map[v].begin(),
-                        proximity_map[v].end(),
-                        [&] (const auto &w1, const auto &w2) -> bool {
-                            return w1.travel_time < w2.travel_time;
+                        travel_times_from(v, targets.data(), targets.size(), times.data());
+
+                        for(auto i = 0u; i < targets.size(); ++i) {
+                            row.push_back({targets[i], times[i]});
                         }
-                );
-            }
+
+                        const auto nth = row.begin() + static_cast<std::ptrdiff_t>(last - first);
+
+                        std::nth_element(row.begin(), nth - 1, row.end(),
+                            [] (const auto& w1, const auto& w2) -> bool {
+                                return w1.travel_time < w2.travel_time;
+                            }
+                        );
+                        std::sort(row.begin(), nth - 1,
+                            [] (const auto& w1, const auto& w2) -> bool {
+                                return w1.travel_time < w2.travel_time;
+                            }
+                        );
+
+                        std::copy(row.begin(), nth, entries.begin() + static_cast<std::ptrdiff_t>(first));
+                    }
+                }
+            );
         }
 
+        proximity_map.offsets = Buffer<std::size_t>(std::move(offsets));
+        proximity_map.entries = Buffer<ProximityMapEntry>(std::move(entries));
+
         std::cout << as::console::notice << "Generated the proximity map." << std::endl;
     }
 
-    float Graph::travel_time(const BoostVertex& v, const BoostVertex& w) const {
-        if(v == w) { return 0.0f; }
-        auto e_found = boost::edge(v, w, g);
+    namespace {
+        // Size and modification time identify the version of the instance file.
+        std::pair<std::uint64_t, std::int64_t> instance_file_stamp(const fs::path& file) {
+            std::error_code ec;
+            const auto size = fs::file_size(file, ec);
+            if(ec) { return {0u, 0}; }
+
+            const auto mtime = fs::last_write_time(file, ec);
+            if(ec) { return {0u, 0}; }
+
+            return {size, static_cast<std::int64_t>(mtime.time_since_epoch().count())};
+        }
+
+        std::uint64_t align_cache_offset(std::uint64_t offset) {
+            const auto a = graph_cache::alignment;
+            return (offset + a - 1u) / a * a;
+        }
+    }
+
+    bool Graph::read_cache(const fs::path& cache_file) {
+        namespace gc = graph_cache;
+        using namespace as::console;
+
+        auto mapping = std::make_shared<const MappedFile>(cache_file);
+
+        if(!mapping->is_open() || mapping->size() < sizeof(gc::Header)) {
+            return false;
+        }
+
+        gc::Header header;
+        std::memcpy(&header, mapping->data(), sizeof(header));
+
+        if(std::memcmp(header.magic, gc::magic, sizeof(gc::magic)) != 0 ||
+           header.version != gc::version ||
+           header.proximity_entry_size != sizeof(ProximityMapEntry) ||
+           header.vertex_index_size != sizeof(VertexIndex))
+        {
+            std::cout << warning << "Ignoring cache file with an unknown format: " << cache_file << std::endl;
+            return false;
+        }
+
+        const auto stamp = instance_file_stamp(graph_file);
+        const auto metric = static_cast<DistanceMetric>(header.metric);
+        const auto backend = static_cast<DistanceOracle::Backend>(header.backend);
+
+        // When the travel times cannot be computed from the coordinates,
+        // the graph falls back from backends which need them to a matrix.
+        const bool same_backend = (backend == options.distance_storage) || (
+            DistanceOracle::needs_coordinates(options.distance_storage) &&
+            metric == DistanceMetric::Explicit
+        );
+
+        if(header.instance_size != stamp.first || header.instance_mtime != stamp.second ||
+           header.n_proximity_neighbours != options.n_proximity_neighbours || !same_backend ||
+           (header.pruned_edges != 0u) != options.prune_infeasible_edges ||
+           (header.renumbered_vertices != 0u) != options.renumber_vertices)
+        {
+            std::cout << notice << "Cache file is stale or was built with different options: " << cache_file << std::endl;
+            return false;
+        }
+
+        const std::size_t n = header.n_vertices;
+        const std::size_t expected_sizes[gc::NumSections] = {
+            n * sizeof(float),
+            n * sizeof(float),
+            n * sizeof(float),
+            VertexArrays::n_bitmap_words(n) * sizeof(std::uint64_t),
+            n * sizeof(double),
+            n * sizeof(double),
+            DistanceOracle::storage_size(backend, n) * sizeof(float),
+            DistanceOracle::quantised_storage_size(backend, n) * sizeof(std::uint16_t),
+            (n + 1u) * sizeof(std::size_t),
+            header.sections[gc::ProximityEntries].size,
+            header.pruned_edges != 0u ? (n + 1u) * sizeof(std::size_t) : 0u,
+            header.sections[gc::FeasibleTargets].size,
+            header.renumbered_vertices != 0u ? n * sizeof(BoostVertex) : 0u
+        };
+
+        for(auto s = 0u; s < gc::NumSections; ++s) {
+            const auto& info = header.sections[s];
+
+            if(info.offset % gc::alignment != 0u ||
+               info.offset + info.size > mapping->size() ||
+               info.size != expected_sizes[s] ||
+               info.size % (s == gc::ProximityEntries ? sizeof(ProximityMapEntry) :
+                            s == gc::FeasibleTargets ? sizeof(VertexIndex) : 1u) != 0u)
+            {
+                std::cout << warning << "Ignoring corrupted cache file: " << cache_file << std::endl;
+                return false;
+            }
+        }
+
+        auto section = [&] (auto element, gc::Section s) {
+            using T = decltype(element);
+            const auto& info = header.sections[s];
+            return Buffer<T>(mapping, info.offset, info.size / sizeof(T));
+        };
+
+        vertex_arrays = VertexArrays(
+            section(float{}, gc::VertexX),
+            section(float{}, gc::VertexY),
+            section(float{}, gc::VertexPrize),
+            section(std::uint64_t{}, gc::VertexReachable)
+        );
+
+        n_vertices = n;
+        n_reachable_vertices = header.n_reachable_vertices;
+        max_travel_time = header.max_travel_time;
+        options.distance_storage = backend;
+
+        for(auto i = 0u; i < n_vertices; ++i) {
+            boost::add_vertex({i, i == 0u, is_reachable(i), vertex_arrays.xs[i], vertex_arrays.ys[i], prize(i)}, g);
+        }
+
+        distances = DistanceOracle(
+            backend,
+            metric,
+            section(double{}, gc::MetricX),
+            section(double{}, gc::MetricY),
+            section(float{}, gc::Distances),
+            section(std::uint16_t{}, gc::QuantisedDistances),
+            header.quantum
+        );
+
+        n_proximity_neighbours = header.n_proximity_neighbours;
+        proximity_map.offsets = section(std::size_t{}, gc::ProximityOffsets);
+        proximity_map.entries = section(ProximityMapEntry{}, gc::ProximityEntries);
+
+        feasible_edges.offsets = section(std::size_t{}, gc::FeasibleOffsets);
+        feasible_edges.targets = section(VertexIndex{}, gc::FeasibleTargets);
+
+        original_ids = section(BoostVertex{}, gc::OriginalIds);
+
+        min_x = header.min_x; max_x = header.max_x;
+        min_y = header.min_y; max_y = header.max_y;
+        min_prize = header.min_prize; max_prize = header.max_prize;
+        total_prize = header.total_prize;
+
+        std::cout << notice << "Read " << n_vertices << " vertices from cache file: " << cache_file << std::endl;
+
+        // Boost edges cannot be mapped from the file: with materialise_edges,
+        // this is the only part of reading the cache which is not (almost) free.
+        generate_edges();
+        generate_spatial_index();
+
+        return true;
+    }
+
+    void Graph::write_cache(const fs::path& cache_file) const {
+        namespace gc = graph_cache;
+        using namespace as::console;
+
+        const std::pair<const void*, std::size_t> contents[gc::NumSections] = {
+            {vertex_arrays.xs.data(), vertex_arrays.xs.size_in_bytes()},
+            {vertex_arrays.ys.data(), vertex_arrays.ys.size_in_bytes()},
+            {vertex_arrays.prizes.data(), vertex_arrays.prizes.size_in_bytes()},
+            {vertex_arrays.reachable.data(), vertex_arrays.reachable.size_in_bytes()},
+            {distances.xs.data(), distances.xs.size_in_bytes()},
+            {distances.ys.data(), distances.ys.size_in_bytes()},
+            {distances.storage.data(), distances.storage.size_in_bytes()},
+            {distances.quantised_storage.data(), distances.quantised_storage.size_in_bytes()},
+            {proximity_map.offsets.data(), proximity_map.offsets.size_in_bytes()},
+            {proximity_map.entries.data(), proximity_map.entries.size_in_bytes()},
+            {feasible_edges.offsets.data(), feasible_edges.offsets.size_in_bytes()},
+            {feasible_edges.targets.data(), feasible_edges.targets.size_in_bytes()},
+            {original_ids.data(), original_ids.size_in_bytes()}
+        };
+
+        gc::Header header{};
+        std::memcpy(header.magic, gc::magic, sizeof(gc::magic));
+        header.version = gc::version;
+        header.metric = static_cast<std::uint32_t>(distances.metric);
+        header.backend = static_cast<std::uint32_t>(distances.backend);
+        header.proximity_entry_size = sizeof(ProximityMapEntry);
+        header.vertex_index_size = sizeof(VertexIndex);
+        std::tie(header.instance_size, header.instance_mtime) = instance_file_stamp(graph_file);
+        header.n_vertices = n_vertices;
+        header.n_reachable_vertices = n_reachable_vertices;
+        header.n_proximity_neighbours = n_proximity_neighbours;
+        header.pruned_edges = has_pruned_edges() ? 1u : 0u;
+        header.renumbered_vertices = original_ids.empty() ? 0u : 1u;
+        header.max_travel_time = max_travel_time;
+        header.quantum = distances.quantum;
+        header.min_x = min_x; header.max_x = max_x;
+        header.min_y = min_y; header.max_y = max_y;
+        header.min_prize = min_prize; header.max_prize = max_prize;
+        header.total_prize = total_prize;
+
+        std::uint64_t offset = align_cache_offset(sizeof(header));
+
+        for(auto s = 0u; s < gc::NumSections; ++s) {
+            header.sections[s] = {offset, contents[s].second};
+            offset = align_cache_offset(offset + contents[s].second);
+        }
+
+        // Write to a temporary file and then rename it, so that concurrent
+        // processes never map a partially written cache.
+        const fs::path tmp_file = cache_file.string() + ".tmp" + std::to_string(::getpid());
+
+        {
+            std::ofstream ofs(tmp_file, std::ios::binary);
+            const char padding[gc::alignment] = {};
+
+            ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            std::uint64_t written = sizeof(header);
+
+            for(auto s = 0u; s < gc::NumSections; ++s) {
+                ofs.write(padding, static_cast<std::streamsize>(header.sections[s].offset - written));
+                ofs.write(static_cast<const char*>(contents[s].first), static_cast<std::streamsize>(contents[s].second));
+                written = header.sections[s].offset + contents[s].second;
+            }
+
+            if(!ofs) {
+                std::cout << warning << "Cannot write cache file: " << tmp_file << std::endl;
+                std::error_code ec;
+                fs::remove(tmp_file, ec);
+                return;
+            }
+        }
 
-        if(!e_found.second) {
-            std::cerr << as::console::error << "Requested travel time of " << v << ", " << w << " which are not adjacent." << std::endl;
-            std::cerr << as::console::error << v << " reachable? " << g[v].reachable << std::endl;
-            std::cerr << as::console::error << w << " reachable? " << g[w].reachable << as::and_die();
+        std::error_code ec;
+        fs::rename(tmp_file, cache_file, ec);
+
+        if(ec) {
+            std::cout << warning << "Cannot write cache file: " << cache_file << std::endl;
+            fs::remove(tmp_file, ec);
+            return;
         }
 
-        return g[e_found.first].travel_time;
+        std::cout << notice << "Wrote preprocessed graph to cache file: " << cache_file << std::endl;
     }
 
     std::pair<float, float> Graph::min_max_vertex_property(float(Vertex::*prop)) const {
@@ -192,6 +823,29 @@ namespace op {
         return std::make_pair(g[*minmax.first].*prop, g[*minmax.second].*prop);
     }
 
+    VertexList Graph::vertices_from_original_ids(const VertexList& ids) const {
+        if(original_ids.empty()) { return ids; }
+
+        VertexList new_ids(n_vertices);
+
+        for(auto v = 0u; v < n_vertices; ++v) {
+            new_ids[original_ids[v]] = static_cast<VertexIndex>(v);
+        }
+
+        VertexList vertices;
+        vertices.reserve(ids.size());
+
+        for(const auto& id : ids) {
+            if(id >= n_vertices) {
+                std::cerr << as::console::error << "Vertex not found: " << id << as::and_die();
+            }
+
+            vertices.push_back(new_ids[id]);
+        }
+
+        return vertices;
+    }
+
     void Graph::set_total_prize() {
         auto vertices_iter = as::graph::vertices(g);
         total_prize = std::accumulate(
@@ -199,7 +853,7 @@ namespace op {
             vertices_iter.end(),
             0.0f,
             [&] (float acc, const BoostVertex& v) -> float {
-                return acc + g[v].prize;
+                return acc + prize(v);
             }
         );
     }
@@ -6,15 +6,16 @@
 #define OP_GRAPH_H
 
 #include <experimental/filesystem>
+#include <cassert>
 #include <vector>
-#include <map>
-#include <as/oplib.h>
 
 #include "GraphTypes.h"
-
-#ifndef PROXIMITY_NEIGHBOURS
-#define PROXIMITY_NEIGHBOURS 20u
-#endif
+#include "SpatialIndex.h"
+#include "GraphOptions.h"
+#include "DistanceOracle.h"
+#include "ProximityMap.h"
+#include "FeasibleEdges.h"
+#include "VertexArrays.h"
 
 namespace op {
     /**
@@ -27,19 +28,37 @@ namespace op {
         std::experimental::filesystem::path graph_file;
 
         /**
-         * Orienteering Problem Instance from as.
+         * Boost graph.
          */
-        std::optional<as::oplib::OPInstance> opi;
+        BoostGraph g;
 
         /**
-         * Boost graph.
+         * Vertex properties of g, stored contiguously for fast access in the
+         * hot loops. Use them (e.g. via prize() and is_reachable()) rather
+         * than the bundled properties of g wherever performance matters.
          */
-        BoostGraph g;
+        VertexArrays vertex_arrays;
+
+        /**
+         * Spatial index of the vertices.
+         */
+        SpatialIndex spatial_index;
+
+        /**
+         * Options used to build the graph.
+         */
+        GraphOptions options;
+
+        /**
+         * Gives O(1) access to travel times between reachable vertices.
+         */
+        DistanceOracle distances;
 
         /**
-         * Boost r-tree.
+         * Edges which can appear in a feasible tour, if the options say to
+         * prune the others; empty otherwise.
          */
-        BoostRTree rtree;
+        FeasibleEdges feasible_edges;
 
         /**
          * Maximum allowed travel time.
@@ -92,50 +111,176 @@ namespace op {
         double total_prize;
 
         /**
-         * Number of neighbours in proximity_map.
+         * Number of neighbours of each vertex in proximity_map.
          */
-        static constexpr std::size_t n_proximity_neighbours = PROXIMITY_NEIGHBOURS;
-
-        struct ProximityMapEntry {
-            BoostVertex vertex;
-            float travel_time;
-        };
-
-        using ProximityMap = std::map<BoostVertex, std::vector<ProximityMapEntry>>;
+        std::size_t n_proximity_neighbours;
 
         /**
-         * Map which associate to each vertex its closest
-         * neighbours, ordered by proximity.
+         * Map which associate to each reachable vertex its closest
+         * reachable neighbours (other than the depot), ordered by
+         * proximity. Unreachable vertices have no neighbours. If edges
+         * are pruned, only neighbours joined by an edge are considered.
          */
         ProximityMap proximity_map;
 
+        /**
+         * Position in the instance file of each vertex, if the vertices
+         * were renumbered; empty otherwise.
+         */
+        Buffer<BoostVertex> original_ids;
+
         /**
          * Default constructor.
          */
         Graph() = default;
 
         /**
-         * Read graph from file.
+         * Read graph from file (or from the cache file given in the options).
          *
-         * @param The graph file.
+         * @param graph_file    The graph file.
+         * @param options       Options controlling how the graph is stored.
          */
-        explicit Graph(std::experimental::filesystem::path graph_file);
+        explicit Graph(std::experimental::filesystem::path graph_file, GraphOptions options = GraphOptions());
 
         /**
          * Builds a graph given the list of vertices and a description
          * of the distance function to use to build the edges, together
          * with the maximum travel time.
          */
-        Graph(std::vector<Vertex> vertices, float max_travel_time);
+        Graph(std::vector<Vertex> vertices, float max_travel_time, GraphOptions options = GraphOptions());
+
+        /**
+         * Tells whether a vertex is reachable from the depot within the maximum travel time.
+         *
+         * @param v The vertex.
+         * @return  True iff it is reachable.
+         */
+        bool is_reachable(const BoostVertex& v) const { return vertex_arrays.is_reachable(v); }
 
         /**
-         * Returns the travel time between two vertices.
+         * Returns the prize of a vertex.
+         *
+         * @param v The vertex.
+         * @return  Its prize.
+         */
+        float prize(const BoostVertex& v) const { return vertex_arrays.prizes[v]; }
+
+        /**
+         * Returns the travel time between two vertices. Both vertices
+         * must be reachable, unless they are the same vertex.
          *
          * @param v First vertex.
          * @param w Second vertex.
          * @return  The travel time.
          */
-        float travel_time(const BoostVertex& v, const BoostVertex& w) const;
+        float travel_time(const BoostVertex& v, const BoostVertex& w) const {
+            assert(v == w || (is_reachable(v) && is_reachable(w)));
+            return distances(v, w);
+        }
+
+        /**
+         * Returns the exact travel time between two vertices, which might
+         * differ from travel_time() if the distance oracle stores approximate
+         * values. Use it whenever feasibility must be guaranteed.
+         *
+         * @param v First vertex.
+         * @param w Second vertex.
+         * @return  The exact travel time.
+         */
+        float exact_travel_time(const BoostVertex& v, const BoostVertex& w) const {
+            assert(v == w || (is_reachable(v) && is_reachable(w)));
+            return distances.exact(v, w);
+        }
+
+        /**
+         * Computes the travel times from a vertex to many others at once.
+         * When travel times are computed from coordinates, this uses the
+         * vectorised kernels, which is much faster than calling travel_time()
+         * in a loop. All vertices must be reachable.
+         *
+         * @param v         The source vertex.
+         * @param targets   The target vertices.
+         * @param n         The number of target vertices.
+         * @param out       Output array, which receives the n travel times.
+         */
+        void travel_times_from(const BoostVertex& v, const VertexIndex* targets, std::size_t n, float* out) const;
+
+        /**
+         * Same as travel_times_from(), but gives exact travel times (see
+         * exact_travel_time()).
+         *
+         * @param v         The source vertex.
+         * @param targets   The target vertices.
+         * @param n         The number of target vertices.
+         * @param out       Output array, which receives the n travel times.
+         */
+        void exact_travel_times_from(const BoostVertex& v, const VertexIndex* targets, std::size_t n, float* out) const;
+
+        /**
+         * Tells whether there is an edge between two vertices, i.e.
+         * whether they are distinct and both reachable and, if edges
+         * were pruned, whether the edge can appear in a feasible tour.
+         *
+         * @param v First vertex.
+         * @param w Second vertex.
+         * @return  True iff the edge exists.
+         */
+        bool has_edge(const BoostVertex& v, const BoostVertex& w) const {
+            return v != w && is_reachable(v) && is_reachable(w) && (feasible_edges.empty() || feasible_edges.contains(v, w));
+        }
+
+        /**
+         * Returns the edge between two vertices, which must exist (see
+         * has_edge()): pruned edges have no descriptor. The edges must be
+         * materialised (see has_materialised_edges()): the program stops
+         * otherwise, as there is no edge to return. Code which only needs
+         * travel times should use travel_time() instead.
+         *
+         * @param v First vertex.
+         * @param w Second vertex.
+         * @return  The edge descriptor.
+         */
+        BoostEdge edge(const BoostVertex& v, const BoostVertex& w) const;
+
+        /**
+         * Tells whether the boost graph stores the edges.
+         */
+        bool has_materialised_edges() const { return options.materialise_edges; }
+
+        /**
+         * Tells whether the edges which cannot appear in a feasible tour were removed.
+         */
+        bool has_pruned_edges() const { return !feasible_edges.empty(); }
+
+        /**
+         * Number of edges in the graph, i.e. pairs of reachable vertices (or
+         * only the feasible ones, if edges were pruned), whether they are
+         * materialised or not.
+         */
+        std::size_t n_edges() const {
+            if(has_pruned_edges()) { return feasible_edges.n_edges(); }
+            return n_reachable_vertices * (n_reachable_vertices - 1u) / 2u;
+        }
+
+        /**
+         * Gives the id that a vertex has in the instance file, which
+         * differs from its id in the graph if vertices were renumbered.
+         *
+         * @param v The vertex.
+         * @return  Its id in the instance file (starting from 0).
+         */
+        BoostVertex original_id(const BoostVertex& v) const {
+            return original_ids.empty() ? v : original_ids[v];
+        }
+
+        /**
+         * Translates ids of vertices in the instance file (starting from 0),
+         * e.g. read from a solution file, into the ids of the graph.
+         *
+         * @param ids   Ids in the instance file.
+         * @return      The corresponding vertices.
+         */
+        VertexList vertices_from_original_ids(const VertexList& ids) const;
 
         /**
          * Instance name (i.e. the graph file without extension).
@@ -152,9 +297,73 @@ namespace op {
     private:
 
         /**
-         * Generate the rtree.
+         * Tries to read the preprocessed graph from a cache file, mapping its
+         * arrays in memory. It fails if the cache does not exist, has a different
+         * format, is older than the instance file, or was built with different
+         * options. The edges of the boost graph are not in the cache: if they
+         * are materialised, they are generated again, in quadratic time.
+         *
+         * @param cache_file    The cache file.
+         * @return              True iff the graph was read.
+         */
+        bool read_cache(const std::experimental::filesystem::path& cache_file);
+
+        /**
+         * Writes the preprocessed graph to a cache file.
+         *
+         * @param cache_file    The cache file.
+         */
+        void write_cache(const std::experimental::filesystem::path& cache_file) const;
+
+        /**
+         * Creates the distance oracle from the vertex coordinates.
+         * If the requested backend cannot represent the metric, it
+         * falls back to a triangular matrix.
+         *
+         * @param metric    The metric to compute travel times from coordinates.
+         * @param xs        The x-coordinates used by the metric.
+         * @param ys        The y-coordinates used by the metric.
+         */
+        void generate_distance_oracle(DistanceMetric metric, std::vector<double> xs, std::vector<double> ys);
+
+        /**
+         * Fills the distance oracle (if it stores travel times) with the
+         * travel times between reachable vertices, computed from the
+         * coordinates. Rows are computed in parallel blocks, and each block
+         * is filled tile by tile to keep the writes to the symmetric entries
+         * cache-friendly; each row of a tile is computed at once by the
+         * vectorised distance kernels. Vertex reachability must already be
+         * known, and the metric cannot be DistanceMetric::Explicit.
+         */
+        void fill_distance_oracle();
+
+        /**
+         * Lengths of the shortest paths from the depot to each reachable
+         * vertex, computed with Dijkstra's algorithm on the complete graph
+         * of reachable vertices (in O(n^2) time). They are the exact travel
+         * times from the depot when these satisfy the triangle inequality.
+         * Unreachable vertices get an infinite length.
+         */
+        std::vector<float> depot_shortest_path_lengths() const;
+
+        /**
+         * Finds the feasible edges, if the options say to prune the others.
+         * Rows are computed in parallel blocks.
+         */
+        void generate_feasible_edges();
+
+        /**
+         * Adds an edge between each pair of reachable vertices (or each
+         * feasible edge, if edges are pruned), with the travel time given
+         * by the distance oracle. Does nothing if the options say not to
+         * materialise the edges.
+         */
+        void generate_edges();
+
+        /**
+         * Generate the spatial index.
          */
-        void generate_rtree();
+        void generate_spatial_index();
 
         /**
          * Calculates and set the total prize among all vertices.
@@ -162,7 +371,12 @@ namespace op {
         void set_total_prize();
 
         /**
-         * Once vertices and edges are built, it generates the proximity map.
+         * Once vertices and the distance oracle are built, it generates the proximity map.
+         * When travel times grow with the euclidean distance between the coordinates, the
+         * neighbours are found with k-nearest-neighbour queries on an r-tree; otherwise, by
+         * partially sorting each row of travel times. If edges are pruned, only the feasible
+         * neighbours are considered, by partially sorting them. Vertices are processed in
+         * parallel.
          */
         void generate_proximity_map();
 
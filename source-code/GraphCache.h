@@ -0,0 +1,124 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#ifndef OP_GRAPHCACHE_H
+#define OP_GRAPHCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace op {
+    /**
+     * Binary cache of a preprocessed graph. The file starts with a
+     * GraphCacheHeader, followed by the sections listed in the header,
+     * each one aligned to graph_cache_alignment bytes. Sections are raw
+     * arrays, written in the native byte order of the machine: the
+     * cache is meant to be shared by processes on the same host, which
+     * map it read-only. The edges of the boost graph are not stored,
+     * so the same cache serves graphs with and without materialised edges.
+     */
+    namespace graph_cache {
+        /**
+         * Magic string at the start of the file.
+         */
+        constexpr char magic[8] = {'O', 'P', 'G', 'R', 'A', 'P', 'H', '\0'};
+
+        /**
+         * Version of the format. It must be increased every time the
+         * layout of the file, or of any of the arrays it contains, changes.
+         */
+        constexpr std::uint32_t version = 7u;
+
+        /**
+         * Alignment of each section, in bytes.
+         */
+        constexpr std::size_t alignment = 64u;
+
+        /**
+         * Sections of the file.
+         */
+        enum Section : std::uint32_t {
+            VertexX,            ///< float: vertex x-coordinates.
+            VertexY,            ///< float: vertex y-coordinates.
+            VertexPrize,        ///< float: vertex prizes.
+            VertexReachable,    ///< uint64: bitmap of reachable vertices (see VertexArrays).
+            MetricX,            ///< double: x-coordinates used by the metric.
+            MetricY,            ///< double: y-coordinates used by the metric.
+            Distances,          ///< float: stored travel times.
+            QuantisedDistances, ///< uint16: stored quantised travel times.
+            ProximityOffsets,   ///< size_t: proximity map offsets.
+            ProximityEntries,   ///< ProximityMapEntry: proximity map entries.
+            FeasibleOffsets,    ///< size_t: feasible edges offsets (empty if edges are not pruned).
+            FeasibleTargets,    ///< VertexIndex: feasible edges targets.
+            OriginalIds,        ///< BoostVertex: vertex ids in the instance file (empty if not renumbered).
+            NumSections
+        };
+
+        /**
+         * Position of a section in the file.
+         */
+        struct SectionInfo {
+            std::uint64_t offset;   ///< Offset from the start of the file, in bytes.
+            std::uint64_t size;     ///< Size, in bytes.
+        };
+
+        /**
+         * Header of the cache file.
+         */
+        struct Header {
+            char magic[8];
+            std::uint32_t version;
+
+            /**
+             * Distance metric and storage backend, as integers.
+             */
+            std::uint32_t metric;
+            std::uint32_t backend;
+
+            /**
+             * Size of the ProximityMapEntry struct, to detect builds with a different layout.
+             */
+            std::uint32_t proximity_entry_size;
+
+            /**
+             * Size of a VertexIndex, which is stored in some sections.
+             */
+            std::uint32_t vertex_index_size;
+
+            /**
+             * Size and last modification time of the instance file,
+             * to detect when the cache is stale.
+             */
+            std::uint64_t instance_size;
+            std::int64_t instance_mtime;
+
+            std::uint64_t n_vertices;
+            std::uint64_t n_reachable_vertices;
+            std::uint64_t n_proximity_neighbours;
+
+            /**
+             * Whether the edges which cannot appear in a feasible tour were pruned.
+             */
+            std::uint32_t pruned_edges;
+
+            /**
+             * Whether the vertices were renumbered along a Hilbert curve.
+             */
+            std::uint32_t renumbered_vertices;
+
+            float max_travel_time;
+            float quantum;
+            float min_x, max_x, min_y, max_y;
+            float min_prize, max_prize;
+            double total_prize;
+
+            SectionInfo sections[NumSections];
+        };
+
+        static_assert(std::is_trivially_copyable<Header>::value, "The cache header must be trivially copyable");
+    }
+}
+
+#endif //OP_GRAPHCACHE_H
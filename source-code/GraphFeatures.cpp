@@ -4,6 +4,7 @@
 
 #include <as/graph.h>
 #include <cmath>
+#include <algorithm>
 
 #include "GraphFeatures.h"
 
@@ -12,9 +13,11 @@ namespace op {
         float diameter(const Graph& graph) {
             float max_diam = 0;
 
-            for(const auto& e : as::graph::edges(graph.g)) {
-                if(graph.g[e].travel_time > max_diam) {
-                    max_diam = graph.g[e].travel_time;
+            for(const auto& v : as::graph::vertices(graph.g)) {
+                for(auto w = v + 1; w < graph.n_vertices; ++w) {
+                    if(!graph.has_edge(v, w)) { continue; }
+
+                    max_diam = std::max(max_diam, graph.travel_time(v, w));
                 }
             }
 
@@ -25,10 +28,10 @@ namespace op {
             const auto depot = 0u;
             float max_dist = 0;
 
-            for(const auto& e : as::graph::out_edges(depot, graph.g)) {
-                if(graph.g[e].travel_time > max_dist) {
-                    max_dist = graph.g[e].travel_time;
-                }
+            for(const auto& v : as::graph::vertices(graph.g)) {
+                if(!graph.has_edge(depot, v)) { continue; }
+
+                max_dist = std::max(max_dist, graph.travel_time(depot, v));
             }
 
             return max_dist / graph.max_travel_time;
@@ -37,18 +40,19 @@ namespace op {
         float distance_btw_barycentre_and_depot(const Graph& graph) {
             using namespace as::geo;
 
-            const float nv = -1.0f + boost::num_edges(graph.g);
+            const float nv = -1.0f + graph.n_edges();
             float tot_x = 0, tot_y = 0;
 
-            for(const auto& v : as::graph::vertices(graph.g)) {
-                if(!graph.g[v].depot) {
-                    tot_x += graph.g[v].x * graph.g[v].prize;
-                    tot_y += graph.g[v].y * graph.g[v].prize;
-                }
+            const auto& va = graph.vertex_arrays;
+
+            // The depot is vertex 0.
+            for(auto v = 1u; v < graph.n_vertices; ++v) {
+                tot_x += va.xs[v] * va.prizes[v];
+                tot_y += va.ys[v] * va.prizes[v];
             }
 
             TwoDimPoint barycentre{tot_x / nv, tot_y / nv};
-            TwoDimPoint depot{graph.g[0u].x, graph.g[0u].y};
+            TwoDimPoint depot{va.xs[0u], va.ys[0u]};
 
             return euclidean_distance(barycentre, depot) / graph.max_travel_time;
         }
@@ -135,8 +139,8 @@ namespace op {
                 std::vector<as::geo::TwoDimPoint> points;
                 points.reserve(graph.n_vertices);
 
-                for(const auto& v : as::graph::vertices(graph.g)) {
-                    points.push_back(as::geo::TwoDimPoint{graph.g[v].x, graph.g[v].y});
+                for(auto v = 0u; v < graph.n_vertices; ++v) {
+                    points.push_back(as::geo::TwoDimPoint{graph.vertex_arrays.xs[v], graph.vertex_arrays.ys[v]});
                 }
 
                 return avg_distance(points);
@@ -162,7 +166,7 @@ namespace op {
                 }
 
                 for(const auto& v : clustering.noise) {
-                    points.push_back(as::geo::TwoDimPoint{clustering.graph->g[v].x, clustering.graph->g[v].y});
+                    points.push_back(as::geo::TwoDimPoint{clustering.graph->vertex_arrays.xs[v], clustering.graph->vertex_arrays.ys[v]});
                 }
 
                 return avg_distance(points);
@@ -193,8 +197,6 @@ namespace op {
         }
 
         namespace {
-            namespace bgi = boost::geometry::index;
-
             BoostBox graph_bounding_rectangle(const Graph& graph) {
                 float min_x = std::numeric_limits<float>::max();
                 float min_y = std::numeric_limits<float>::max();
@@ -217,29 +219,29 @@ namespace op {
             }
 
             std::size_t pts_in_horizontal_strip(float start_y, float width, const BoostBox& br, const Graph& graph) {
-                std::vector<BoostTreeValue> points;
+                std::size_t n_points = 0u;
 
                 // Removing epsilon to avoid counting points exactly at the intersection of two strips twice.
                 const BoostBox bounding(
                     BoostPoint(br.min_corner().x(), start_y),
                     BoostPoint(br.max_corner().x(), start_y + width - std::numeric_limits<float>::epsilon())
                 );
-                graph.rtree.query(bgi::within(bounding), std::back_inserter(points));
+                for_each_within(graph.spatial_index, bounding, [&] (const BoostTreeValue&) { ++n_points; });
 
-                return points.size();
+                return n_points;
             }
 
             std::size_t pts_in_vertical_strip(float start_x, float width, const BoostBox& br, const Graph& graph) {
-                std::vector<BoostTreeValue> points;
+                std::size_t n_points = 0u;
 
                 // Removing epsilon to avoid counting points exactly at the intersection of two strips twice.
                 const BoostBox bounding(
                     BoostPoint(start_x, br.min_corner().y()),
                     BoostPoint(start_x + width - std::numeric_limits<float>::epsilon(), br.max_corner().y())
                 );
-                graph.rtree.query(bgi::within(bounding), std::back_inserter(points));
+                for_each_within(graph.spatial_index, bounding, [&] (const BoostTreeValue&) { ++n_points; });
 
-                return points.size();
+                return n_points;
             }
 
             std::size_t pts_in_diagonal_strip(float start_intercept, float width, const Graph& graph) {
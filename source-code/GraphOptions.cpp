@@ -0,0 +1,17 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#include "GraphOptions.h"
+#include "ParallelFor.h"
+
+namespace op {
+    GraphOptions::GraphOptions() :
+        distance_storage{DistanceOracle::Backend::DenseMatrix},
+        materialise_edges{true},
+        prune_infeasible_edges{false},
+        renumber_vertices{false},
+        n_threads{default_n_threads()},
+        n_proximity_neighbours{20u}
+    {}
+}
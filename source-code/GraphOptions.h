@@ -0,0 +1,81 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#ifndef OP_GRAPHOPTIONS_H
+#define OP_GRAPHOPTIONS_H
+
+#include <experimental/filesystem>
+#include <cstddef>
+#include "DistanceOracle.h"
+
+namespace op {
+    /**
+     * Options which control how a Graph is built and stored.
+     */
+    struct GraphOptions {
+        /**
+         * How the travel times between vertices are stored.
+         */
+        DistanceOracle::Backend distance_storage;
+
+        /**
+         * Whether to store an edge for each pair of reachable vertices in
+         * the boost graph. On large instances the complete graph takes
+         * several GB, so it can be turned off: travel times are then only
+         * available through the distance oracle (see Graph::travel_time),
+         * and asking for an edge descriptor stops the program (see
+         * Graph::edge). This does not choose distance_storage, which is a
+         * dense matrix by default.
+         */
+        bool materialise_edges;
+
+        /**
+         * Whether to keep only the edges which can appear in a feasible tour,
+         * i.e. edges (i, j) such that a shortest path from the depot to i, plus
+         * the edge, plus a shortest path from j to the depot, fits within the
+         * maximum travel time. On instances with a tight maximum travel time
+         * this removes most edges; missing edges are treated as infeasible
+         * (see Graph::has_edge), while their travel times are still available.
+         */
+        bool prune_infeasible_edges;
+
+        /**
+         * Whether to renumber the vertices read from an instance file along
+         * a Hilbert curve (keeping the depot at 0), so that vertices which
+         * are close in the plane get close ids, and their travel times and
+         * properties are close in memory. Solutions are read and written
+         * with the ids of the instance file.
+         */
+        bool renumber_vertices;
+
+        /**
+         * Number of threads used to build the graph.
+         */
+        std::size_t n_threads;
+
+        /**
+         * Number of closest neighbours to store for each vertex
+         * in the proximity map.
+         */
+        std::size_t n_proximity_neighbours;
+
+        /**
+         * Binary cache of the preprocessed graph (empty for no cache). If it
+         * is valid for the instance and the options, the graph is mapped from
+         * it; otherwise, the graph is built from the instance and the cache
+         * is (re)written. Only used when reading the graph from a file.
+         * The boost graph edges are not cached, and are rebuilt when edges are
+         * materialised: the cache only avoids most of the start-up time together
+         * with materialise_edges = false.
+         */
+        std::experimental::filesystem::path cache_file;
+
+        /**
+         * Default options.
+         */
+        GraphOptions();
+    };
+}
+
+#endif //OP_GRAPHOPTIONS_H
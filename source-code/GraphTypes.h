@@ -5,6 +5,10 @@
 #ifndef OP_GRAPHTYPES_H
 #define OP_GRAPHTYPES_H
 
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <boost/container/small_vector.hpp>
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/graph_traits.hpp>
 #include <boost/geometry.hpp>
@@ -79,6 +83,52 @@ namespace op {
      */
     using BoostVertex = boost::graph_traits<BoostGraph>::vertex_descriptor;
 
+    /**
+     * Compact vertex id, used in the containers of the solver (tours, lists
+     * of free vertices, clusters, proximity map) instead of BoostVertex,
+     * which is only used at the interface with boost. It has 32 bits, or 16
+     * bits if OP_VERTEX_INDEX_16 is defined, which halves the size of these
+     * containers again on instances with at most 65536 vertices. Graphs
+     * check that their vertices fit when they are built.
+     */
+#if defined(OP_VERTEX_INDEX_16)
+    using VertexIndex = std::uint16_t;
+#else
+    using VertexIndex = std::uint32_t;
+#endif
+
+    /**
+     * List of vertices, e.g. the vertices visited by a tour.
+     */
+    using VertexList = std::vector<VertexIndex>;
+
+    /**
+     * Number of vertices which small vertex lists and bitmaps store inline,
+     * i.e. without allocating memory on the heap. The default covers the
+     * OPLIB instances (up to 400 vertices); lists of larger instances spill
+     * over to the heap, as a std::vector would. It can be changed at compile
+     * time by defining OP_SMALL_LIST_CAPACITY.
+     */
+#if defined(OP_SMALL_LIST_CAPACITY)
+    constexpr std::size_t small_list_capacity = OP_SMALL_LIST_CAPACITY;
+#else
+    constexpr std::size_t small_list_capacity = 512u;
+#endif
+
+    /**
+     * List of vertices with inline storage for small_list_capacity vertices.
+     * Used for the lists which are copied together with each solution (tours,
+     * free vertices) and for temporaries of the destroy and repair methods,
+     * so that on small instances they do not allocate memory at all.
+     */
+    using SmallVertexList = boost::container::small_vector<VertexIndex, small_list_capacity>;
+
+    /**
+     * Bitmap with one bit per vertex, with inline storage for the bitmap of
+     * small_list_capacity vertices.
+     */
+    using VertexBitmap = boost::container::small_vector<std::uint64_t, (small_list_capacity + 63u) / 64u>;
+
     /**
      * Convenient typedef for a boost edge.
      */
@@ -104,12 +154,12 @@ namespace op {
     /**
      * R-tree used to store the vertex values. Points in this R-tree
      * can be queried, and most queries take O(log n) time, which is
-     * a big speedup vs linear search.
-     * TODO: benchmark alternatives to R-Star.
+     * a big speedup vs linear search. Other spatial indices are listed
+     * in SpatialIndex.h.
      */
     using BoostRTree = boost::geometry::index::rtree<
     BoostTreeValue, // Type of data to store in the tree.
-    boost::geometry::index::rstar<16, 4>>; // For now, we use R-star.
+    boost::geometry::index::rstar<16, 4>>; // R-star node splitting.
 }
 
 #endif //OP_GRAPHTYPES_H
@@ -12,10 +12,15 @@
 
 namespace op {
     Tour GreedyHeuristic::solve() const {
+        auto mt = as::rnd::get_seeded_mt();
+        return solve(mt);
+    }
+
+    Tour GreedyHeuristic::solve(std::mt19937& mt) const {
         Tour tour;
 
         if(params.initial_solution.use_clustering) {
-            auto red = recursive_reduction(&graph);
+            auto red = recursive_reduction(&graph, 0.5f, params.local_search.tsp_options(mt()));
 
             if(red) {
                 // If the graph could be reduced, give a
@@ -34,12 +39,11 @@ namespace op {
         }
 
         if(params.initial_solution.local_search) {
-            tour.do_2opt();
+            PALNSSolution sol(tour, &params);
+            sol.do_2opt();
+            sol.do_or_opt();
 
-            PALNSSolution sol(tour);
             GreedyRepair rep(&params);
-            auto mt = as::rnd::get_seeded_mt();
-
             rep.repair_solution(sol, mt);
             tour = sol.tour;
         }
@@ -66,7 +70,7 @@ namespace op {
 
             red.reduced_graph.max_travel_time /= 2.75f;
         } else {
-            std::vector<BoostVertex> vertices = { 0u, 1u };
+            SmallVertexList vertices = { 0u, 1u };
             tour = Tour(&red.reduced_graph, vertices);
         }
 
@@ -76,14 +80,14 @@ namespace op {
     Tour GreedyHeuristic::solve_without_clustering() const {
         assert(graph.n_vertices >= 2u);
 
-        std::vector<BoostVertex> vertices = { 0u };
-        std::vector<BoostVertex> other_vertices(graph.n_vertices - 1u);
+        SmallVertexList vertices = { 0u };
+        VertexList other_vertices(graph.n_vertices - 1u);
         std::iota(other_vertices.begin(), other_vertices.end(), 1u);
 
         other_vertices.erase(
             std::remove_if(other_vertices.begin(), other_vertices.end(),
                 [&] (const auto& v) -> bool {
-                    return !graph.g[v].reachable;
+                    return !graph.is_reachable(v);
                 }
             ),
             other_vertices.end()
@@ -94,7 +98,7 @@ namespace op {
         } else if(params.initial_solution.vertex_order == "prize") {
             std::sort(other_vertices.begin(), other_vertices.end(),
                 [&] (const auto& v1, const auto& v2) -> bool {
-                    return graph.g[v1].prize < graph.g[v2].prize;
+                    return graph.prize(v1) < graph.prize(v2);
                 }
             );
         } else if(params.initial_solution.vertex_order == "distance") {
@@ -124,13 +128,13 @@ namespace op {
     Tour GreedyHeuristic::solve_with_clustering_constructive(ReducedGraph& red) const {
         assert(red.reduced_graph.n_vertices >= 2u);
 
-        std::vector<BoostVertex> vertices = { 0u };
+        SmallVertexList vertices = { 0u };
         Tour tour(&red.reduced_graph, vertices);
 
         PALNSSolution sol(tour);
 
         for(auto v = 1u; v < red.reduced_graph.n_vertices; ++v) {
-            if(red.reduced_graph.g[v].reachable) {
+            if(red.reduced_graph.is_reachable(v)) {
                 sol.add_vertex_in_best_pos_any(v);
             }
         }
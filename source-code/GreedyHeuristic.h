@@ -8,6 +8,7 @@
 #include "palns/PALNSProblemParams.h"
 #include "Graph.h"
 #include "ReducedGraph.h"
+#include <random>
 
 namespace op {
     /**
@@ -41,6 +42,16 @@ namespace op {
          */
         Tour solve() const;
 
+        /**
+         * Produce a greedy heuristic solution, drawing the random
+         * choices (and the seed of the TSP heuristic) from a given
+         * random number generator.
+         *
+         * @param mt    The random number generator.
+         * @return      The greedy solution.
+         */
+        Tour solve(std::mt19937& mt) const;
+
         /**
          * Produce a greedy heuristic solution, without using the graph clustering.
          * 
@@ -0,0 +1,67 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#include "HilbertCurve.h"
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <utility>
+
+namespace op {
+    std::uint64_t hilbert_index(std::uint32_t x, std::uint32_t y) {
+        constexpr std::uint32_t side = 1u << 16u;
+        std::uint64_t d = 0u;
+
+        for(auto s = side / 2u; s > 0u; s /= 2u) {
+            const std::uint32_t rx = (x & s) > 0u ? 1u : 0u;
+            const std::uint32_t ry = (y & s) > 0u ? 1u : 0u;
+
+            d += static_cast<std::uint64_t>(s) * s * ((3u * rx) ^ ry);
+
+            // Rotate the quadrant, so that the curve is continuous.
+            if(ry == 0u) {
+                if(rx == 1u) {
+                    x = side - 1u - x;
+                    y = side - 1u - y;
+                }
+                std::swap(x, y);
+            }
+        }
+
+        return d;
+    }
+
+    std::vector<BoostVertex> hilbert_order(const std::vector<double>& xs, const std::vector<double>& ys) {
+        assert(xs.size() == ys.size());
+
+        const auto n = xs.size();
+        std::vector<BoostVertex> order(n);
+        std::iota(order.begin(), order.end(), 0u);
+
+        if(n <= 2u) { return order; }
+
+        const auto x_range = std::minmax_element(xs.begin(), xs.end());
+        const auto y_range = std::minmax_element(ys.begin(), ys.end());
+        const auto min_x = *x_range.first, min_y = *y_range.first;
+        const auto size = std::max({*x_range.second - min_x, *y_range.second - min_y, 1e-6});
+
+        // Use the same scale on both axes, so that the curve is not distorted.
+        const auto scale = 65535.0 / size;
+
+        std::vector<std::uint64_t> keys(n);
+
+        for(auto i = 0u; i < n; ++i) {
+            const auto cx = static_cast<std::uint32_t>(std::min(65535.0, (xs[i] - min_x) * scale));
+            const auto cy = static_cast<std::uint32_t>(std::min(65535.0, (ys[i] - min_y) * scale));
+            keys[i] = hilbert_index(cx, cy);
+        }
+
+        std::stable_sort(order.begin() + 1, order.end(),
+            [&keys] (BoostVertex v, BoostVertex w) { return keys[v] < keys[w]; }
+        );
+
+        return order;
+    }
+}
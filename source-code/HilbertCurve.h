@@ -0,0 +1,36 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#ifndef OP_HILBERTCURVE_H
+#define OP_HILBERTCURVE_H
+
+#include <cstdint>
+#include <vector>
+#include "GraphTypes.h"
+
+namespace op {
+    /**
+     * Position along a Hilbert curve of order 16 of a point of the
+     * 65536 x 65536 grid. Points which are close on the curve are close in
+     * the plane, so visiting them in this order gives good locality.
+     *
+     * @param x Column of the point.
+     * @param y Row of the point.
+     * @return  The position of the point along the curve.
+     */
+    std::uint64_t hilbert_index(std::uint32_t x, std::uint32_t y);
+
+    /**
+     * Orders the vertices along a Hilbert curve over their bounding box,
+     * leaving the depot (vertex 0) first. Ties, i.e. vertices falling in the
+     * same cell of the grid, keep their relative order.
+     *
+     * @param xs    Vertex x-coordinates.
+     * @param ys    Vertex y-coordinates.
+     * @return      The vertices, in the order in which the curve visits them.
+     */
+    std::vector<BoostVertex> hilbert_order(const std::vector<double>& xs, const std::vector<double>& ys);
+}
+
+#endif //OP_HILBERTCURVE_H
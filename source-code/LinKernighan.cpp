@@ -2,206 +2,412 @@
 // Created by alberto on 20/10/17.
 //
 
-#include <as/file_stream.h>
-#include <as/containers.h>
-#include <as/console.h>
-#include <as/and_die.h>
-#include <cstdlib>
-#include <cstring>
-#include <fstream>
-#include <utility>
-#include <map>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <random>
 #include "LinKernighan.h"
 #include "Graph.h"
 
 namespace op {
-    namespace fs = std::experimental::filesystem;
-
-    struct LKHInstance {
-        fs::path params_file;
-        fs::path instance_file;
-        fs::path tour_file;
-        std::map<std::size_t, std::size_t> vertex_id_mapping;
-    };
-
-    LKHInstance generate_lkh_params(const Graph& g, const std::vector<BoostVertex>& vertices, std::string unique_name) {
-        using namespace as;
-
-        const auto inst_name = g.instance_name();
-        const auto tmp_dir = fs::temp_directory_path();
-        const auto tsp_file = tmp_dir / (inst_name + unique_name + ".tmp.tsp");
-        const auto params_file = tmp_dir / (inst_name + unique_name + ".tmp.par");
-        const auto tour_file = tmp_dir / (inst_name + unique_name + ".tmp.sol");
-
-        std::map<std::size_t, std::size_t> vertex_id_mapping;
-        for(auto i = 0u; i < vertices.size(); ++i) {
-            vertex_id_mapping[i + 1] = g.g[vertices[i]].id;
-        }
+    LinKernighanOptions::LinKernighanOptions() :
+        max_trials{0u},
+        time_limit{1.0},
+        n_neighbours{10u},
+        seed{1u}
+    {}
+
+    namespace {
+        /**
+         * Tsps with at most this many vertices get their candidate
+         * neighbours by comparing all pairs of vertices; larger ones
+         * take them from the proximity map of the graph.
+         */
+        constexpr std::size_t max_n_vertices_all_pairs = 1000u;
+
+        /**
+         * Tour over the local indices 0, ..., n - 1 of the vertices of a tsp,
+         * stored as the sequence of indices and the position of each index.
+         * Moves are applied as reversals of paths of the tour: a path and its
+         * complement give the same cyclic tour, so the shorter one is reversed
+         * and the orientation of the tour is not fixed.
+         */
+        struct LocalSearchTour {
+            const Graph& g;
+            const VertexList& vertices;
+            const std::size_t n;
+
+            /**
+             * Local indices, in tour order.
+             */
+            std::vector<std::uint32_t> order;
+
+            /**
+             * Position of each local index in order.
+             */
+            std::vector<std::uint32_t> pos;
+
+            /**
+             * Candidate neighbours of each local index, sorted by travel
+             * time, in compressed sparse row format.
+             */
+            std::vector<std::size_t> neighbour_offsets;
+            std::vector<std::uint32_t> neighbours;
+
+            /**
+             * Indices whose don't-look bit is off: they are in to_look iff
+             * active is set.
+             */
+            std::vector<std::uint8_t> active;
+            std::vector<std::uint32_t> to_look;
+
+            /**
+             * Length of the tour, updated with the gain of each move.
+             */
+            double length;
+
+            /**
+             * Minimum gain for a move to be applied.
+             */
+            float epsilon;
+
+            LocalSearchTour(const Graph& g, const VertexList& vertices, std::size_t n_neighbours) :
+                g{g}, vertices{vertices}, n{vertices.size()}, order(n), pos(n), active(n, 0u)
+            {
+                for(auto i = 0u; i < n; ++i) {
+                    order[i] = pos[i] = i;
+                }
+
+                length = 0.0;
+                for(auto i = 0u; i < n; ++i) {
+                    length += d(i, (i + 1u) % n);
+                }
 
-        {
-            std::ofstream tofs(tsp_file);
+                epsilon = std::max(1e-6f, 1e-4f * static_cast<float>(length / n));
 
-            if(tofs.fail()) {
-                std::cerr << console::error << "Cannot open temporary file " << tsp_file << and_die();
+                generate_neighbours(n_neighbours);
             }
 
-            tofs << "NAME: " << inst_name << "\n";
-            tofs << "TYPE: TSP\n";
-            tofs << "DIMENSION: " << vertices.size() << "\n";
+            float d(std::uint32_t i, std::uint32_t j) const {
+                return g.travel_time(vertices[i], vertices[j]);
+            }
 
-            if(g.opi) {
-                // If it has info from the original instance file, use them.
+            std::uint32_t succ(std::uint32_t i) const { return order[(pos[i] + 1u) % n]; }
+            std::uint32_t pred(std::uint32_t i) const { return order[(pos[i] + n - 1u) % n]; }
 
-                std::string weight_type = g.opi->get_raw_specification<std::string>("EDGE_WEIGHT_TYPE");
-                tofs << "EDGE_WEIGHT_TYPE: " << weight_type << "\n";
+            void generate_neighbours(std::size_t n_neighbours) {
+                neighbour_offsets.assign(n + 1u, 0u);
 
-                std::string weight_format;
-                try {
-                    weight_format = g.opi->get_raw_specification<std::string>("EDGE_WEIGHT_FORMAT");
-                    tofs << "EDGE_WEIGHT_FORMAT: " << weight_format << "\n";
-                } catch(...) {
-                    // No such specification.
-                }
+                std::vector<std::pair<float, std::uint32_t>> candidates;
 
-                if(weight_type == "EXPLICIT") {
-                    // Print weight matrix
-                    tofs << "EDGE_WEIGHT_SECTION\n";
+                if(n <= max_n_vertices_all_pairs) {
+                    const auto k = std::min(n_neighbours, n - 1u);
 
-                    if(weight_format == "UPPER_ROW") {
-                        for(auto i = 0u; i < vertices.size(); ++i) {
-                            for(auto j = i + 1; j < vertices.size(); ++j) {
-                                tofs << g.opi->get_distance(i, j) << " ";
-                            }
-                            tofs << "\n";
+                    for(std::uint32_t i = 0u; i < n; ++i) {
+                        candidates.clear();
+
+                        for(std::uint32_t j = 0u; j < n; ++j) {
+                            if(j != i) { candidates.emplace_back(d(i, j), j); }
                         }
-                    } else {
-                        assert(weight_format == "LOWER_DIAG_ROW");
 
-                        for(auto i = 0u; i < vertices.size(); ++i) {
-                            for(auto j = 0u; j < i; ++j) {
-                                tofs << g.opi->get_distance(i, j) << " ";
-                            }
-                            tofs << "0 ";
+                        std::partial_sort(candidates.begin(), candidates.begin() + k, candidates.end());
+
+                        for(auto c = 0u; c < k; ++c) {
+                            neighbours.push_back(candidates[c].second);
                         }
-                        tofs << "\n";
+
+                        neighbour_offsets[i + 1u] = neighbours.size();
                     }
                 } else {
-                    // Print vertices coordinates
-                    tofs << "NODE_COORD_SECTION\n";
+                    // Only keep the neighbours in the proximity map which are part of the tsp.
+                    std::vector<std::int64_t> local_id(g.n_vertices, -1);
 
-                    for(auto i = 0u; i < vertices.size(); ++i) {
-                        const auto coords = g.opi->get_original_coordinates(vertices[i]);
-                        tofs << i + 1 << " " << coords.x << " " << coords.y << "\n";
-                        vertex_id_mapping[i + 1] = g.g[vertices[i]].id;
+                    for(auto i = 0u; i < n; ++i) {
+                        local_id[vertices[i]] = i;
                     }
+
+                    for(std::uint32_t i = 0u; i < n; ++i) {
+                        std::size_t n_found = 0u;
+
+                        for(const auto& neighbour : g.proximity_map[vertices[i]]) {
+                            if(n_found == n_neighbours) { break; }
+                            if(local_id[neighbour.vertex] < 0) { continue; }
+
+                            neighbours.push_back(static_cast<std::uint32_t>(local_id[neighbour.vertex]));
+                            ++n_found;
+                        }
+
+                        neighbour_offsets[i + 1u] = neighbours.size();
+                    }
+                }
+            }
+
+            void activate(std::uint32_t i) {
+                if(!active[i]) {
+                    active[i] = 1u;
+                    to_look.push_back(i);
+                }
+            }
+
+            void activate_all() {
+                for(auto i = 0u; i < n; ++i) { activate(order[i]); }
+            }
+
+            /**
+             * Reverses the path from x to y, following the tour.
+             */
+            void reverse_path(std::uint32_t x, std::uint32_t y) {
+                auto first = pos[x], last = pos[y];
+                auto path_length = (last + n - first) % n + 1u;
+
+                if(2u * path_length > n) {
+                    // Reverse the complement, which is shorter.
+                    first = (pos[y] + 1u) % n;
+                    last = (pos[x] + n - 1u) % n;
+                    path_length = n - path_length;
                 }
-            } else {
-                // Otherwise, use the computed info.
 
-                tofs << "EDGE_WEIGHT_TYPE: EUC_2D\n";
-                tofs << "NODE_COORD_SECTION\n";
+                for(auto k = 0u; k < path_length / 2u; ++k) {
+                    std::swap(order[first], order[last]);
+                    pos[order[first]] = first;
+                    pos[order[last]] = last;
+                    first = (first + 1u) % n;
+                    last = (last + n - 1u) % n;
+                }
+            }
 
-                for(auto i = 0u; i < vertices.size(); ++i) {
-                    const auto& v = g.g[vertices[i]];
-                    tofs << i + 1 << " " << v.x << " " << v.y << "\n";
+            /**
+             * Replaces edges (a1, a2) and (b1, b2) with (a1, b1) and (a2, b2).
+             * Either a2 and b2 follow a1 and b1, or they precede them.
+             */
+            void move_2opt(std::uint32_t a1, std::uint32_t a2, std::uint32_t b1, std::uint32_t b2) {
+                if(succ(a1) == a2) {
+                    assert(succ(b1) == b2);
+                    reverse_path(a2, b1);
+                } else {
+                    assert(pred(a1) == a2 && pred(b1) == b2);
+                    reverse_path(a1, b2);
                 }
             }
 
-            tofs << "EOF\n";
-        }
+            bool improve_2opt(std::uint32_t a) {
+                for(auto forward : {true, false}) {
+                    const auto a2 = forward ? succ(a) : pred(a);
+                    const auto a_edge = d(a, a2);
+
+                    for(auto k = neighbour_offsets[a]; k < neighbour_offsets[a + 1u]; ++k) {
+                        const auto c = neighbours[k];
+                        const auto new_edge = d(a, c);
+
+                        if(new_edge >= a_edge) { break; }
+
+                        const auto c2 = forward ? succ(c) : pred(c);
+
+                        if(c == a2 || c2 == a) { continue; }
+
+                        const auto gain = a_edge + d(c, c2) - new_edge - d(a2, c2);
+
+                        if(gain > epsilon) {
+                            move_2opt(a, a2, c, c2);
+                            length -= gain;
 
-        {
-            std::ofstream pofs(params_file);
+                            activate(a);
+                            activate(a2);
+                            activate(c);
+                            activate(c2);
 
-            if(pofs.fail()) {
-                std::cerr << console::error << "Cannot open temporary file " << params_file << and_die();
+                            return true;
+                        }
+                    }
+                }
+
+                return false;
             }
 
-            pofs << "PROBLEM_FILE = " << tsp_file.string() << "\n";
-            pofs << "TOUR_FILE = " << tour_file.string() << "\n";
-            pofs << "RUNS = 1\n";
-        }
+            bool improve_or_opt(std::uint32_t s) {
+                for(auto forward : {true, false}) {
+                    // Segment of 1 to 3 vertices starting from s, in either direction.
+                    std::uint32_t segment[3u] = {s, s, s};
 
-        return {params_file, tsp_file, tour_file, vertex_id_mapping};
-    }
+                    for(auto segment_length = 1u; segment_length <= 3u && segment_length + 3u <= n; ++segment_length) {
+                        if(segment_length > 1u) {
+                            const auto prev = segment[segment_length - 2u];
+                            segment[segment_length - 1u] = forward ? succ(prev) : pred(prev);
+                        }
 
-    Tour run_lin_kernighan(const Graph& g, const std::vector<BoostVertex>& vertices, std::string unique_name) {
-        using namespace as::fstream;
-        using namespace as::console;
-        using as::and_die;
+                        const auto s_end = segment[segment_length - 1u];
 
-        // Special case, if |vertices| <= 3.
-        if(vertices.size() == 1u) {
-            return Tour();
-        } else if(vertices.size() == 2u) {
-            auto e = boost::edge(vertices[0u], vertices[1u], g.g).first;
-            return Tour(&g, std::vector<BoostEdge>({e, e}));
-        } else if(vertices.size() == 3u) {
-            auto e1 = boost::edge(vertices[0u], vertices[1u], g.g).first;
-            auto e2 = boost::edge(vertices[1u], vertices[2u], g.g).first;
-            auto e3 = boost::edge(vertices[2u], vertices[0u], g.g).first;
-            return Tour(&g, {e1, e2, e3});
-        }
+                        // Endpoints of the segment, and its neighbours, following the tour.
+                        const auto a = forward ? s : s_end;
+                        const auto b = forward ? s_end : s;
+                        const auto p = pred(a);
+                        const auto q = succ(b);
 
-        auto lkhinst = generate_lkh_params(g, vertices, unique_name);
+                        const auto removal_gain = d(p, a) + d(b, q) - d(p, q);
 
-        std::string cmd = "~/local/bin/LKH " + lkhinst.params_file.string() + " >/dev/null 2>&1";
-        int exit_code = std::system(cmd.c_str());
+                        if(removal_gain <= epsilon) { continue; }
 
-        if(exit_code != 0) {
-            std::cerr << error << "LKH executable failed; exit code: " << std::strerror(exit_code) << and_die();
-        }
+                        const auto in_segment = [&] (std::uint32_t v) -> bool {
+                            return std::find(segment, segment + segment_length, v) != segment + segment_length;
+                        };
 
-        if(!fs::exists(lkhinst.tour_file)) {
-            std::cerr << error << "Expected solution file not produced: " << lkhinst.tour_file << and_die();
-        }
+                        for(auto end : {a, b}) {
+                            for(auto k = neighbour_offsets[end]; k < neighbour_offsets[end + 1u]; ++k) {
+                                const auto c = neighbours[k];
 
-        std::ifstream ifs(lkhinst.tour_file);
+                                if(d(end, c) >= removal_gain) { break; }
+                                if(in_segment(c)) { continue; }
 
-        if(ifs.fail()) {
-            std::cerr << error << "Solution file could not be read: " << lkhinst.tour_file << and_die();
-        }
+                                // Try the edges (c, succ(c)) and (pred(c), c).
+                                for(auto c_first : {true, false}) {
+                                    const auto u = c_first ? c : pred(c);
+                                    const auto w = c_first ? succ(c) : c;
 
-        skip_lines(ifs, 6u);
+                                    if(in_segment(u) || in_segment(w)) { continue; }
 
-        BoostVertex start_node, current_node;
+                                    const auto straight = d(u, a) + d(b, w);
+                                    const auto reversed = d(u, b) + d(a, w);
+                                    const auto gain = removal_gain - std::min(straight, reversed) + d(u, w);
 
-        if(!(ifs >> start_node)) {
-            std::cerr << error << "Cannot read first node of tsp solution." << and_die();
-        }
+                                    if(gain > epsilon) {
+                                        move_or_opt(p, a, b, q, u, w, reversed < straight);
+                                        length -= gain;
+
+                                        for(auto v : {p, q, a, b, u, w}) { activate(v); }
 
-        start_node = lkhinst.vertex_id_mapping.at(start_node);
+                                        return true;
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
 
-        std::vector<BoostEdge> edges;
-        edges.reserve(vertices.size());
+                return false;
+            }
 
-        current_node = start_node;
+            /**
+             * Moves the path a, ..., b (where p precedes a and q follows b) between
+             * u and w = succ(u), as three 2-opt moves. Afterwards, u is adjacent to
+             * a, or to b if reversed.
+             */
+            void move_or_opt(std::uint32_t p, std::uint32_t a, std::uint32_t b, std::uint32_t q, std::uint32_t u, std::uint32_t w, bool reversed) {
+                // p a ... b q ... u w  ->  p u ... q b ... a w
+                move_2opt(p, a, u, w);
+                // p u ... q b ... a w  ->  p q ... u b ... a w
+                move_2opt(p, u, q, b);
+
+                if(!reversed) {
+                    // u b ... a w  ->  u a ... b w
+                    move_2opt(u, b, a, w);
+                }
+            }
 
-        while(true) {
-            long int next_node;
+            void local_search() {
+                while(!to_look.empty()) {
+                    const auto a = to_look.back();
+                    to_look.pop_back();
+                    active[a] = 0u;
 
-            if(!(ifs >> next_node)) {
-                std::cerr << error << "Cannot read next node; current one: " << current_node << and_die();
+                    if(!improve_2opt(a)) {
+                        improve_or_opt(a);
+                    }
+                }
             }
 
-            if(next_node == -1) {
-                auto edge = boost::edge(current_node, start_node, g.g).first;
-                edges.push_back(edge);
-                break;
-            } else {
-                assert(next_node >= 0);
-                next_node = lkhinst.vertex_id_mapping.at(static_cast<std::size_t>(next_node));
-
-                auto edge = boost::edge(current_node, static_cast<BoostVertex>(next_node), g.g).first;
-                edges.push_back(edge);
-                current_node = static_cast<BoostVertex>(next_node);
+            /**
+             * Double-bridge kick, which swaps two consecutive short segments.
+             */
+            void kick(std::mt19937& mt) {
+                const auto max_segment_length = std::max<std::size_t>(1u, std::min<std::size_t>(50u, (n - 2u) / 2u));
+
+                std::uniform_int_distribution<std::size_t> start_dist(0u, n - 1u);
+                std::uniform_int_distribution<std::size_t> length_dist(1u, max_segment_length);
+
+                const auto start = start_dist(mt);
+                const auto l1 = length_dist(mt);
+                const auto l2 = length_dist(mt);
+
+                const auto at = [&] (std::size_t k) { return order[(start + k) % n]; };
+
+                // x B C y  ->  x C B y
+                const auto x = at(0u), b1 = at(1u), b2 = at(l1), c1 = at(l1 + 1u), c2 = at(l1 + l2), y = at(l1 + l2 + 1u);
+
+                length += d(x, c1) + d(c2, b1) + d(b2, y) - d(x, b1) - d(b2, c1) - d(c2, y);
+
+                std::vector<std::uint32_t> segments(l1 + l2);
+                for(auto k = 0u; k < l1 + l2; ++k) { segments[k] = at(k + 1u); }
+                std::rotate(segments.begin(), segments.begin() + l1, segments.end());
+
+                for(auto k = 0u; k < l1 + l2; ++k) {
+                    const auto position = static_cast<std::uint32_t>((start + k + 1u) % n);
+                    order[position] = segments[k];
+                    pos[segments[k]] = position;
+                }
+
+                for(auto v : {x, b1, b2, c1, c2, y}) { activate(v); }
+            }
+
+            void set_order(const std::vector<std::uint32_t>& new_order, double new_length) {
+                order = new_order;
+                for(auto k = 0u; k < n; ++k) { pos[order[k]] = k; }
+                length = new_length;
+            }
+        };
+    }
+
+    Tour run_lin_kernighan(const Graph& g, const VertexList& vertices, const LinKernighanOptions& options) {
+        // Special case, if |vertices| <= 3.
+        if(vertices.size() == 1u) {
+            return Tour();
+        } else if(vertices.size() <= 3u) {
+            return Tour(&g, SmallVertexList(vertices.begin(), vertices.end()));
+        }
+
+        using clock = std::chrono::steady_clock;
+        const auto start_time = clock::now();
+
+        LocalSearchTour tour{g, vertices, options.n_neighbours};
+
+        tour.activate_all();
+        tour.local_search();
+
+        auto best_order = tour.order;
+        auto best_length = tour.length;
+
+        // Kicks need two segments, and a vertex on each side.
+        if(vertices.size() >= 8u) {
+            const auto max_trials = options.max_trials > 0u ? options.max_trials : vertices.size();
+            std::mt19937 mt{options.seed};
+
+            for(auto trial = 0u; trial < max_trials; ++trial) {
+                const std::chrono::duration<double> elapsed = clock::now() - start_time;
+                if(elapsed.count() > options.time_limit) { break; }
+
+                tour.kick(mt);
+                tour.local_search();
+
+                if(tour.length < best_length - tour.epsilon) {
+                    best_order = tour.order;
+                    best_length = tour.length;
+                } else {
+                    tour.set_order(best_order, best_length);
+                }
             }
         }
 
-        fs::remove(lkhinst.params_file);
-        fs::remove(lkhinst.instance_file);
-        fs::remove(lkhinst.tour_file);
+        // Start from the first vertex.
+        const auto first = std::find(best_order.begin(), best_order.end(), 0u);
+        std::rotate(best_order.begin(), first, best_order.end());
+
+        SmallVertexList tour_vertices;
+        tour_vertices.reserve(vertices.size());
+
+        for(const auto& i : best_order) {
+            tour_vertices.push_back(vertices[i]);
+        }
 
-        return Tour(&g, edges);
+        return Tour(&g, tour_vertices);
     }
-}
\ No newline at end of file
+}
@@ -6,21 +6,56 @@
 #define OP_LINKERNIGHAN_H
 
 #include "Tour.h"
+#include <cstddef>
 #include <vector>
 
 namespace op {
     /**
-     * Runs an external solver to provide a TSP solution using the Lin-Kernighan
-     * heuristic. The result is a Hamiltonian tour of the vertices specified.
+     * Options which control the budget of run_lin_kernighan().
+     */
+    struct LinKernighanOptions {
+        /**
+         * Maximum number of trials, i.e. of kicks followed by a local search.
+         * If zero, the number of vertices of the tsp is used (as in LKH).
+         */
+        std::size_t max_trials;
+
+        /**
+         * Maximum time to spend on trials, in seconds.
+         */
+        double time_limit;
+
+        /**
+         * Number of candidate neighbours of each vertex, for the moves.
+         */
+        std::size_t n_neighbours;
+
+        /**
+         * Seed of the random number generator used for the kicks.
+         */
+        unsigned int seed;
+
+        /**
+         * Builds the default options.
+         */
+        LinKernighanOptions();
+    };
+
+    /**
+     * Provides a TSP solution with an in-process iterated local search: the
+     * local search uses 2-opt and Or-opt (Or-3opt) moves on candidate lists
+     * of close vertices, with don't-look bits, and it is restarted from
+     * double-bridge kicks of the best tour found, as in Lin-Kernighan
+     * heuristics. The result is a Hamiltonian tour of the vertices specified,
+     * starting from the first of them.
      *
      * @param g           The underlying graph.
      * @param vertices    The subset of vertices for which a tour is required.
-     * @param unique_name A unique name for the set of vertices passed to the function.
-     *                    This can be used to solve many tsps in parallel, and make sure
-     *                    that LKH reads different files with different names.
-     * @return            The best tour produced by LKH.
+     *                    Their order is used as the starting tour.
+     * @param options     The budget for the search.
+     * @return            The best tour found.
      */
-    Tour run_lin_kernighan(const Graph& g, const std::vector<BoostVertex>& vertices, std::string unique_name = "");
+    Tour run_lin_kernighan(const Graph& g, const VertexList& vertices, const LinKernighanOptions& options = LinKernighanOptions());
 }
 
 #endif //OP_LINKERNIGHAN_H
@@ -0,0 +1,185 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#include "LinkedTour.h"
+#include "Graph.h"
+
+namespace op {
+    LinkedTour::LinkedTour(const Tour& tour) :
+        graph{tour.graph},
+        next(tour.graph->n_vertices),
+        prev(tour.graph->n_vertices),
+        visited{tour.visited},
+        length{tour.vertices.size()},
+        travel_time{tour.travel_time},
+        total_prize{tour.total_prize}
+    {
+        assert(!tour.vertices.empty());
+        assert(tour.vertices.front() == 0u);
+
+        for(auto i = 0u; i < length; ++i) {
+            const auto v = tour.vertices[i];
+            const auto w = tour.vertices[(i + 1u) % length];
+
+            next[v] = w;
+            prev[w] = v;
+        }
+    }
+
+    SmallVertexList LinkedTour::vertices() const {
+        SmallVertexList vertices;
+        vertices.reserve(length);
+
+        BoostVertex v = 0u;
+
+        do {
+            vertices.push_back(static_cast<VertexIndex>(v));
+            v = next[v];
+        } while(v != 0u);
+
+        assert(vertices.size() == length);
+
+        return vertices;
+    }
+
+    Tour LinkedTour::to_tour() const {
+        return Tour{graph.get(), vertices()};
+    }
+
+    void LinkedTour::add_vertex(const BoostVertex& vertex, const BoostVertex& after) {
+        assert(visits_vertex(after));
+        assert(!visits_vertex(vertex));
+        assert(!graph->g[vertex].depot);
+        assert(graph->is_reachable(vertex));
+
+        const auto before = static_cast<VertexIndex>(after);
+        const auto following = next[before];
+
+        if(length == 1u) {
+            travel_time = 2 * graph->exact_travel_time(0u, vertex);
+        } else {
+            travel_time -= graph->exact_travel_time(before, following);
+            travel_time += graph->exact_travel_time(before, vertex);
+            travel_time += graph->exact_travel_time(vertex, following);
+        }
+
+        next[before] = static_cast<VertexIndex>(vertex);
+        prev[vertex] = before;
+        next[vertex] = following;
+        prev[following] = static_cast<VertexIndex>(vertex);
+
+        visited[vertex / 64u] |= std::uint64_t{1u} << (vertex % 64u);
+        ++length;
+        total_prize += graph->prize(vertex);
+    }
+
+    bool LinkedTour::remove_vertex(const BoostVertex& vertex) {
+        assert(vertex != 0u); // The depot.
+        assert(visits_vertex(vertex));
+
+        if(length == 1u) {
+            return false;
+        }
+
+        const auto before = prev[vertex];
+        const auto after = next[vertex];
+
+        if(length == 2u) {
+            travel_time = 0.0f;
+        } else {
+            travel_time -= graph->exact_travel_time(before, vertex) +
+                           graph->exact_travel_time(vertex, after) -
+                           graph->exact_travel_time(before, after);
+        }
+
+        next[before] = after;
+        prev[after] = before;
+
+        visited[vertex / 64u] &= ~(std::uint64_t{1u} << (vertex % 64u));
+        --length;
+        total_prize -= graph->prize(vertex);
+
+        return true;
+    }
+
+    VertexRemovalPrice LinkedTour::price_vertex_removal(const BoostVertex& vertex) const {
+        assert(vertex != 0u);
+        assert(visits_vertex(vertex));
+
+        const auto vertex_before = prev[vertex];
+        const auto vertex_after = next[vertex];
+
+        const auto decrease_in_travel_time = graph->travel_time(vertex_before, vertex) +
+                                             graph->travel_time(vertex, vertex_after) -
+                                             graph->travel_time(vertex_before, vertex_after);
+
+        const auto decrease_in_prize = graph->prize(vertex);
+
+        return {static_cast<VertexIndex>(vertex), decrease_in_travel_time, decrease_in_prize, decrease_in_travel_time / decrease_in_prize};
+    }
+
+    LinkedInsertionPrice LinkedTour::price_vertex_insertion(const BoostVertex& vertex, const BoostVertex& after) const {
+        assert(visits_vertex(after));
+        assert(!visits_vertex(vertex));
+
+        const auto vertex_after = next[after];
+
+        const auto increase_in_travel_time = graph->travel_time(after, vertex) +
+                                             graph->travel_time(vertex, vertex_after) -
+                                             graph->travel_time(after, vertex_after);
+
+        const auto increase_in_prize = graph->prize(vertex);
+
+        return {static_cast<VertexIndex>(vertex), static_cast<VertexIndex>(after), increase_in_travel_time, increase_in_prize, increase_in_travel_time / increase_in_prize};
+    }
+
+    void LinkedTour::price_vertex_insertions(const BoostVertex& vertex, std::vector<LinkedInsertionPrice>& insertions) const {
+        assert(!visits_vertex(vertex));
+
+        const auto sequence = vertices();
+
+        std::vector<float> travel_times(sequence.size());
+        graph->travel_times_from(vertex, sequence.data(), sequence.size(), travel_times.data());
+
+        const auto increase_in_prize = graph->prize(vertex);
+
+        insertions.reserve(insertions.size() + sequence.size());
+
+        for(auto i = 0u; i < sequence.size(); ++i) {
+            const auto j = (i + 1u) % sequence.size();
+            const auto increase_in_travel_time = travel_times[i] +
+                                                 travel_times[j] -
+                                                 graph->travel_time(sequence[i], sequence[j]);
+
+            insertions.push_back({static_cast<VertexIndex>(vertex), sequence[i], increase_in_travel_time, increase_in_prize, increase_in_travel_time / increase_in_prize});
+        }
+    }
+
+    bool LinkedTour::is_insertion_feasible(const LinkedInsertionPrice& insertion) const {
+        const auto vertex_before = this->vertex_before(insertion);
+        const auto vertex_after = this->vertex_after(insertion);
+
+        if(graph->has_pruned_edges()) {
+            // Pruned edges cannot be part of any feasible tour.
+            if(!graph->has_edge(vertex_before, insertion.vertex) || !graph->has_edge(insertion.vertex, vertex_after)) {
+                return false;
+            }
+        }
+
+        const auto new_travel_time = travel_time + insertion.increase_in_travel_time;
+
+        // The increase is made of three travel times, each of which can be approximate.
+        const auto tolerance = 3.0f * graph->distances.max_error();
+
+        if(new_travel_time + tolerance <= graph->max_travel_time) { return true; }
+        if(new_travel_time - tolerance > graph->max_travel_time) { return false; }
+
+        // Close to the boundary: recompute the increase exactly.
+        const auto exact_increase = graph->exact_travel_time(vertex_before, insertion.vertex) +
+                                    graph->exact_travel_time(insertion.vertex, vertex_after) -
+                                    graph->exact_travel_time(vertex_before, vertex_after);
+
+        return travel_time + exact_increase <= graph->max_travel_time;
+    }
+}
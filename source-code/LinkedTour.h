@@ -0,0 +1,214 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#ifndef OP_LINKEDTOUR_H
+#define OP_LINKEDTOUR_H
+
+#include <experimental/memory>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include "GraphTypes.h"
+#include "Tour.h"
+
+namespace op {
+    /**
+     * Price of inserting a vertex in a LinkedTour. It identifies the
+     * insertion by the vertex preceding the new vertex, rather than by
+     * a position in a list of vertices as VertexInsertionPrice does.
+     */
+    struct LinkedInsertionPrice {
+        VertexIndex vertex;
+        VertexIndex vertex_before;
+        float increase_in_travel_time;
+        float increase_in_prize;
+        float score;
+    };
+
+    /**
+     * Alternative representation of a simple closed tour, as a doubly
+     * linked list stored in two arrays indexed by vertex. Adding and
+     * removing a vertex take O(1) time, instead of the O(n) vector
+     * insert/erase of Tour, which makes it suitable for repairs which
+     * perform many insertions on tours with thousands of vertices.
+     *
+     * It exposes the same pricing API as Tour, with one difference:
+     * insertions are LinkedInsertionPrice, identified by the vertex
+     * immediately preceding the new vertex, rather than by its index in
+     * the vertices list. Since vertices do not move when others are added
+     * or removed, insertions stay valid until the edge leaving the
+     * preceding vertex changes.
+     */
+    struct LinkedTour {
+        /**
+         * Non-owning pointer to the graph containing the tour.
+         */
+        std::experimental::observer_ptr<const Graph> graph;
+
+        /**
+         * Successor of each vertex visited by the tour, indexed by vertex.
+         * Entries of vertices which are not visited are meaningless.
+         */
+        VertexList next;
+
+        /**
+         * Predecessor of each vertex visited by the tour, indexed by vertex.
+         * Entries of vertices which are not visited are meaningless.
+         */
+        VertexList prev;
+
+        /**
+         * Bitmap of the vertices visited by the tour: vertex v is
+         * visited iff bit v % 64 of word v / 64 is set.
+         */
+        VertexBitmap visited;
+
+        /**
+         * Number of vertices visited by the tour, including the depot.
+         */
+        std::size_t length;
+
+        /**
+         * Total travel time along the tour.
+         */
+        float travel_time;
+
+        /**
+         * Total prize collected along the tour.
+         */
+        float total_prize;
+
+        /**
+         * Default constructor.
+         */
+        LinkedTour() = default;
+
+        /**
+         * Builds the linked representation of a tour, in O(n) time.
+         *
+         * @param tour The tour.
+         */
+        explicit LinkedTour(const Tour& tour);
+
+        /**
+         * Gives the vertices of the tour, in order, starting from the depot.
+         *
+         * @return The list of vertices.
+         */
+        SmallVertexList vertices() const;
+
+        /**
+         * Converts back to a vector-based tour, in O(n) time.
+         *
+         * @return The equivalent tour.
+         */
+        Tour to_tour() const;
+
+        /**
+         * Tells whether the tour visits a vertex.
+         *
+         * @param v The vertex.
+         * @return  True iff the tour visits the vertex.
+         */
+        bool visits_vertex(const BoostVertex& v) const {
+            return (visited[v / 64u] >> (v % 64u)) & 1u;
+        }
+
+        /**
+         * Translates an insertion priced on a tour into the same insertion
+         * on the linked representation of that tour.
+         *
+         * @param tour      The tour the insertion was priced on.
+         * @param insertion The insertion.
+         * @return          The equivalent insertion.
+         */
+        static LinkedInsertionPrice translate_insertion(const Tour& tour, const VertexInsertionPrice& insertion) {
+            return {
+                insertion.vertex,
+                tour.vertices[insertion.position],
+                insertion.increase_in_travel_time,
+                insertion.increase_in_prize,
+                insertion.score
+            };
+        }
+
+        /**
+         * Gives the vertex immediately preceding the vertex added by an
+         * insertion priced on this tour.
+         */
+        BoostVertex vertex_before(const LinkedInsertionPrice& insertion) const {
+            return insertion.vertex_before;
+        }
+
+        /**
+         * Gives the vertex immediately following the vertex added by an
+         * insertion priced on this tour.
+         */
+        BoostVertex vertex_after(const LinkedInsertionPrice& insertion) const {
+            assert(visits_vertex(insertion.vertex_before));
+            return next[insertion.vertex_before];
+        }
+
+        /**
+         * Adds a vertex to the tour, just after another vertex which must be
+         * visited by the tour. After = 0 means that the vertex is added just
+         * after the depot.
+         *
+         * @param vertex    The vertex to add.
+         * @param after     The vertex after which to add it.
+         */
+        void add_vertex(const BoostVertex& vertex, const BoostVertex& after);
+
+        /**
+         * Removes a vertex from the tour. The vertex must be visited by the
+         * tour, and it cannot be the depot. This method follows the same
+         * rules as Tour::remove_vertex().
+         *
+         * @param vertex    The vertex to remove.
+         * @return          True iff the vertex was removed.
+         */
+        bool remove_vertex(const BoostVertex& vertex);
+
+        /**
+         * Prices the removal of a vertex visited by the tour, other than the depot.
+         *
+         * @param vertex    The vertex.
+         * @return          Vertex removal price.
+         */
+        VertexRemovalPrice price_vertex_removal(const BoostVertex& vertex) const;
+
+        /**
+         * Prices the insertion of a vertex just after another vertex, which
+         * must be visited by the tour.
+         *
+         * @param vertex    The vertex.
+         * @param after     The vertex after which it would be added.
+         * @return          Vertex insertion price.
+         */
+        LinkedInsertionPrice price_vertex_insertion(const BoostVertex& vertex, const BoostVertex& after) const;
+
+        /**
+         * Prices the insertion of a vertex after every vertex of the tour,
+         * appending the prices to a vector in tour order, starting from the
+         * depot. Travel times are computed in a single batch, as in
+         * Tour::price_vertex_insertions().
+         *
+         * @param vertex        The vertex.
+         * @param insertions    The vector where to append the prices.
+         */
+        void price_vertex_insertions(const BoostVertex& vertex, std::vector<LinkedInsertionPrice>& insertions) const;
+
+        /**
+         * Tells whether an insertion keeps the tour's travel time within the
+         * maximum travel time, with the same exactness guarantees as
+         * Tour::is_insertion_feasible().
+         *
+         * @param insertion     The insertion, priced on this tour.
+         * @return              True iff the tour after the insertion is feasible.
+         */
+        bool is_insertion_feasible(const LinkedInsertionPrice& insertion) const;
+    };
+}
+
+#endif //OP_LINKEDTOUR_H
@@ -0,0 +1,39 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace op {
+    MappedFile::MappedFile(const std::experimental::filesystem::path& path) : data_{nullptr}, size_{0u} {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+
+        if(fd < 0) { return; }
+
+        struct stat file_stat;
+
+        if(::fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+            const auto size = static_cast<std::size_t>(file_stat.st_size);
+            void* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+
+            if(addr != MAP_FAILED) {
+                data_ = static_cast<const char*>(addr);
+                size_ = size;
+            }
+        }
+
+        // The mapping stays valid after the descriptor is closed.
+        ::close(fd);
+    }
+
+    MappedFile::~MappedFile() {
+        if(data_ != nullptr) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+    }
+}
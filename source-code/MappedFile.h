@@ -0,0 +1,63 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#ifndef OP_MAPPEDFILE_H
+#define OP_MAPPEDFILE_H
+
+#include <experimental/filesystem>
+#include <cstddef>
+
+namespace op {
+    /**
+     * A file mapped read-only in memory. The mapping is shared, so
+     * that different processes mapping the same file share its pages
+     * through the page cache. The file is unmapped on destruction.
+     */
+    class MappedFile {
+        /**
+         * Start of the mapped memory, or nullptr if the mapping failed.
+         */
+        const char* data_;
+
+        /**
+         * Size of the mapped memory, in bytes.
+         */
+        std::size_t size_;
+
+    public:
+
+        /**
+         * Maps a file. If the file cannot be opened or mapped, the object
+         * is constructed anyway, but is_open() returns false.
+         *
+         * @param path  The file to map.
+         */
+        explicit MappedFile(const std::experimental::filesystem::path& path);
+
+        /**
+         * Unmaps the file.
+         */
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /**
+         * Tells whether the file was mapped successfully.
+         */
+        bool is_open() const { return data_ != nullptr; }
+
+        /**
+         * Start of the mapped memory.
+         */
+        const char* data() const { return data_; }
+
+        /**
+         * Size of the mapped memory, in bytes.
+         */
+        std::size_t size() const { return size_; }
+    };
+}
+
+#endif //OP_MAPPEDFILE_H
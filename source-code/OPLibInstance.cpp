@@ -0,0 +1,233 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#include "OPLibInstance.h"
+
+#include <as/and_die.h>
+#include <as/console.h>
+#include <iostream>
+#include <algorithm>
+#include <charconv>
+#include <iterator>
+#include <cstring>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+namespace op {
+    namespace fs = std::experimental::filesystem;
+
+    namespace {
+        bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+        bool is_space(char c) { return is_blank(c) || c == '\n'; }
+
+        // Skips spaces (including new lines) starting at p.
+        const char* skip_spaces(const char* p, const char* end) {
+            while(p < end && is_space(*p)) { ++p; }
+            return p;
+        }
+
+        // Position just after the end of the line containing p.
+        const char* next_line(const char* p, const char* end) {
+            const auto* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+            return nl ? nl + 1 : end;
+        }
+
+        // Value of a "KEY : VALUE" field, without surrounding whitespace.
+        std::string_view field_value(const char* p, const char* end) {
+            while(p < end && is_blank(*p)) { ++p; }
+            if(p < end && *p == ':') { ++p; }
+            while(p < end && is_blank(*p)) { ++p; }
+
+            const auto* last = p;
+            while(last < end && *last != '\n') { ++last; }
+            while(last > p && is_blank(*(last - 1))) { --last; }
+
+            return {p, static_cast<std::size_t>(last - p)};
+        }
+    }
+
+    template<typename T>
+    const char* OPLibInstance::read_number(const char* p, T& value) const {
+        const auto* end = file.data() + file.size();
+
+        p = skip_spaces(p, end);
+
+        // std::from_chars does not accept a leading plus sign.
+        if(p < end && *p == '+') { ++p; }
+
+        const auto result = std::from_chars(p, end, value);
+
+        if(result.ec != std::errc{}) {
+            std::cerr << as::console::error << "Expected a number in instance " << name << " at byte ";
+            std::cerr << (p - file.data()) << as::and_die();
+        }
+
+        return result.ptr;
+    }
+
+    template const char* OPLibInstance::read_number(const char*, float&) const;
+    template const char* OPLibInstance::read_number(const char*, double&) const;
+
+    OPLibInstance::OPLibInstance(const fs::path& instance_file) : file{instance_file}, name{instance_file.stem()} {
+        using namespace as::console;
+
+        if(!file.is_open()) {
+            std::cerr << error << "Cannot read instance file: " << instance_file << as::and_die();
+        }
+
+        const auto* const begin = file.data();
+        const auto* const end = begin + file.size();
+
+        bool has_cost_limit = false, has_coordinates = false, has_display_data = false, has_prizes = false;
+        std::string_view edge_weight_type;
+
+        // Reads a section made of n_vertices lines "id value_1 ... value_k" and
+        // stores value_c into the c-th column, at index id - 1. Returns the end of the section.
+        auto read_vertex_section = [&] (const char* p, const char* section, auto&... columns) {
+            if(n_vertices == 0u) {
+                std::cerr << error << "The DIMENSION must precede the " << section << " in instance " << name << as::and_die();
+            }
+
+            (columns.assign(n_vertices, 0), ...);
+
+            double id;
+
+            for(auto k = 0u; k < n_vertices; ++k) {
+                p = read_number(p, id);
+
+                // Check the id before converting it: negative or huge values do not fit a size_t.
+                if(!(id >= 1.0 && id <= static_cast<double>(n_vertices)) || id != std::floor(id)) {
+                    std::cerr << error << "Invalid vertex id in the " << section << " of instance " << name << as::and_die();
+                }
+
+                const auto i = static_cast<std::size_t>(id) - 1u;
+
+                ((p = read_number(p, columns[i])), ...);
+            }
+
+            return p;
+        };
+
+        const char* p = begin;
+
+        while(p < end) {
+            p = skip_spaces(p, end);
+            if(p == end) { break; }
+
+            // Lines which do not start with a keyword belong to sections we skip.
+            if(!std::isalpha(static_cast<unsigned char>(*p))) {
+                p = next_line(p, end);
+                continue;
+            }
+
+            const auto* key_end = p;
+            while(key_end < end && (std::isalnum(static_cast<unsigned char>(*key_end)) || *key_end == '_')) { ++key_end; }
+
+            const std::string_view key{p, static_cast<std::size_t>(key_end - p)};
+
+            if(key == "EOF") {
+                break;
+            } else if(key == "NAME") {
+                name = std::string(field_value(key_end, end));
+            } else if(key == "DIMENSION") {
+                double dimension;
+                read_number(field_value(key_end, end).data(), dimension);
+
+                if(!(dimension >= 1.0 && dimension <= static_cast<double>(std::numeric_limits<std::uint32_t>::max())) ||
+                   dimension != std::floor(dimension))
+                {
+                    std::cerr << error << "Invalid DIMENSION in instance " << name << as::and_die();
+                }
+
+                n_vertices = static_cast<std::size_t>(dimension);
+            } else if(key == "COST_LIMIT") {
+                read_number(field_value(key_end, end).data(), max_travel_time);
+                has_cost_limit = true;
+            } else if(key == "EDGE_WEIGHT_TYPE") {
+                edge_weight_type = field_value(key_end, end);
+                metric = metric_from_edge_weight_type(std::string(edge_weight_type));
+            } else if(key == "EDGE_WEIGHT_FORMAT") {
+                edge_weight_format = std::string(field_value(key_end, end));
+            } else if(key == "NODE_COORD_SECTION") {
+                p = read_vertex_section(next_line(key_end, end), "NODE_COORD_SECTION", xs, ys);
+                has_coordinates = true;
+                continue;
+            } else if(key == "DISPLAY_DATA_SECTION") {
+                if(!has_coordinates) {
+                    p = read_vertex_section(next_line(key_end, end), "DISPLAY_DATA_SECTION", xs, ys);
+                    has_display_data = true;
+                    continue;
+                }
+            } else if(key == "NODE_SCORE_SECTION") {
+                p = read_vertex_section(next_line(key_end, end), "NODE_SCORE_SECTION", prizes);
+                has_prizes = true;
+                continue;
+            } else if(key == "DEPOT_SECTION") {
+                float depot;
+                read_number(next_line(key_end, end), depot);
+
+                if(depot != 1.0f) {
+                    std::cerr << error << "The depot must be the first vertex, in instance " << name << as::and_die();
+                }
+            } else if(key == "EDGE_WEIGHT_SECTION") {
+                // Only remember where it starts: it is read by for_each_edge_weight().
+                edge_weights = next_line(key_end, end);
+            }
+
+            p = next_line(p, end);
+        }
+
+        if(n_vertices == 0u) {
+            std::cerr << error << "Missing DIMENSION in instance " << name << as::and_die();
+        }
+
+        if(!has_cost_limit) {
+            std::cerr << error << "Missing COST_LIMIT in instance " << name << as::and_die();
+        }
+
+        if(!has_prizes) {
+            std::cerr << error << "Missing NODE_SCORE_SECTION in instance " << name << as::and_die();
+        }
+
+        if(metric == DistanceMetric::Explicit && edge_weight_type != "EXPLICIT") {
+            std::cout << warning << "EDGE_WEIGHT_TYPE " << edge_weight_type << " is not supported natively: ";
+            std::cout << "reading instance " << name << " with the AS reader." << std::endl;
+
+            fallback.emplace(instance_file.string());
+
+            // Use the coordinates of the AS reader, as for its travel times.
+            xs.resize(n_vertices);
+            ys.resize(n_vertices);
+            has_coordinates = true;
+
+            for(auto i = 0u; i < n_vertices; ++i) {
+                xs[i] = fallback->get_coordinates(i).x;
+                ys[i] = fallback->get_coordinates(i).y;
+            }
+        } else if(metric == DistanceMetric::Explicit) {
+            static const char* const formats[] = {
+                "FULL_MATRIX", "UPPER_ROW", "LOWER_ROW", "UPPER_DIAG_ROW", "LOWER_DIAG_ROW",
+                "UPPER_COL", "LOWER_COL", "UPPER_DIAG_COL", "LOWER_DIAG_COL"
+            };
+
+            if(std::find(std::begin(formats), std::end(formats), edge_weight_format) == std::end(formats)) {
+                std::cerr << error << "Unsupported EDGE_WEIGHT_FORMAT " << edge_weight_format << " in instance " << name << as::and_die();
+            }
+
+            if(edge_weights == nullptr) {
+                std::cerr << error << "Missing EDGE_WEIGHT_SECTION in instance " << name << as::and_die();
+            }
+        } else if(!has_coordinates) {
+            std::cerr << error << "Missing NODE_COORD_SECTION in instance " << name << as::and_die();
+        }
+
+        if(!has_coordinates && !has_display_data) {
+            xs.assign(n_vertices, 0.0);
+            ys.assign(n_vertices, 0.0);
+        }
+    }
+}
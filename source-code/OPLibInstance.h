@@ -0,0 +1,161 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#ifndef OP_OPLIBINSTANCE_H
+#define OP_OPLIBINSTANCE_H
+
+#include <experimental/filesystem>
+#include <as/oplib.h>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "DistanceOracle.h"
+
+namespace op {
+    /**
+     * An Orienteering Problem instance in OPLIB format (i.e. a TSPLIB file
+     * with a COST_LIMIT and a NODE_SCORE_SECTION). The file is mapped in
+     * memory and parsed in place, in a single pass: the coordinates and the
+     * prizes are read in the constructor, while explicit travel times are
+     * only read on demand, by for_each_edge_weight(), so that they can be
+     * stored directly into their final destination.
+     *
+     * Instances whose EDGE_WEIGHT_TYPE is neither EXPLICIT nor one of the
+     * metrics of DistanceMetric are read with the OPLIB reader of AS,
+     * instead, and their travel times are reported as explicit ones.
+     */
+    class OPLibInstance {
+        /**
+         * The mapped instance file.
+         */
+        MappedFile file;
+
+        /**
+         * Start of the data of the EDGE_WEIGHT_SECTION, or nullptr if there is none.
+         */
+        const char* edge_weights = nullptr;
+
+        /**
+         * Instance read by AS, if the EDGE_WEIGHT_TYPE is not supported natively.
+         */
+        std::optional<as::oplib::OPInstance> fallback;
+
+        /**
+         * Reads a number starting at p, after skipping any whitespace, and dies if there is none.
+         *
+         * @tparam T    Type of the number: float or double.
+         * @param p     Position where to start reading.
+         * @param value Receives the number read.
+         * @return      The position just after the number.
+         */
+        template<typename T>
+        const char* read_number(const char* p, T& value) const;
+
+    public:
+
+        /**
+         * Instance name, from the NAME field.
+         */
+        std::string name;
+
+        /**
+         * Number of vertices, from the DIMENSION field.
+         */
+        std::size_t n_vertices = 0u;
+
+        /**
+         * Maximum travel time, from the COST_LIMIT field.
+         */
+        float max_travel_time = 0.0f;
+
+        /**
+         * Metric given by the EDGE_WEIGHT_TYPE field.
+         */
+        DistanceMetric metric = DistanceMetric::Explicit;
+
+        /**
+         * Layout of the EDGE_WEIGHT_SECTION, from the EDGE_WEIGHT_FORMAT field.
+         */
+        std::string edge_weight_format;
+
+        /**
+         * Vertex coordinates, from the NODE_COORD_SECTION or, if there is
+         * none, from the DISPLAY_DATA_SECTION. They are zero if the file
+         * has neither of these sections. They are read in double precision,
+         * so that travel times computed from them match the TSPLIB ones.
+         */
+        std::vector<double> xs, ys;
+
+        /**
+         * Vertex prizes, from the NODE_SCORE_SECTION.
+         */
+        std::vector<float> prizes;
+
+        /**
+         * Maps and parses an instance file. Dies if the file cannot be
+         * read or is not a valid OPLIB instance.
+         *
+         * @param instance_file The instance file.
+         */
+        explicit OPLibInstance(const std::experimental::filesystem::path& instance_file);
+
+        /**
+         * Tells whether travel times are given explicitly in the file.
+         */
+        bool has_explicit_weights() const { return metric == DistanceMetric::Explicit; }
+
+        /**
+         * Reads the EDGE_WEIGHT_SECTION, calling fn(i, j, travel_time) for
+         * each pair of vertices i < j, in the order they appear in the file.
+         * Travel times are assumed symmetric: with a FULL_MATRIX, only the
+         * upper triangle is reported. For EDGE_WEIGHT_TYPEs which are not
+         * supported natively, the travel times come from the AS reader.
+         *
+         * @tparam Fn   Type of the function receiving the travel times.
+         * @param  fn   The function.
+         */
+        template<typename Fn>
+        void for_each_edge_weight(Fn&& fn) const;
+    };
+
+    template<typename Fn>
+    void OPLibInstance::for_each_edge_weight(Fn&& fn) const {
+        if(fallback) {
+            for(auto i = 0u; i < n_vertices; ++i) {
+                for(auto j = i + 1u; j < n_vertices; ++j) {
+                    fn(i, j, static_cast<float>(fallback->get_distance(i, j)));
+                }
+            }
+
+            return;
+        }
+
+        const auto n = n_vertices;
+        const auto& f = edge_weight_format;
+
+        // Row-wise upper triangles are the same as column-wise lower triangles, and vice versa.
+        const bool full = (f == "FULL_MATRIX");
+        const bool upper = (f == "UPPER_ROW" || f == "UPPER_DIAG_ROW" || f == "LOWER_COL" || f == "LOWER_DIAG_COL");
+        const bool diagonal = (f == "UPPER_DIAG_ROW" || f == "LOWER_DIAG_ROW" || f == "UPPER_DIAG_COL" || f == "LOWER_DIAG_COL");
+
+        const char* p = edge_weights;
+        float w;
+
+        for(auto i = 0u; i < n; ++i) {
+            const std::size_t first = full ? 0u : (upper ? (diagonal ? i : i + 1u) : 0u);
+            const std::size_t last = full ? n : (upper ? n : (diagonal ? i + 1u : i));
+
+            for(auto j = first; j < last; ++j) {
+                p = read_number(p, w);
+
+                if(i < j) { fn(i, j, w); }
+                else if(j < i && !full) { fn(j, i, w); }
+            }
+        }
+    }
+}
+
+#endif //OP_OPLIBINSTANCE_H
@@ -0,0 +1,77 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#ifndef OP_PARALLELFOR_H
+#define OP_PARALLELFOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace op {
+    /**
+     * Default number of threads to use for parallel loops: the
+     * number of hardware threads, or 1 if it cannot be detected.
+     */
+    inline std::size_t default_n_threads() {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    /**
+     * Splits the range [begin, end) in blocks of (at most) block_size
+     * consecutive indices, and calls fn(block_begin, block_end) on each
+     * block. Blocks are handed out dynamically to n_threads threads, so
+     * that the load is balanced even if blocks have different costs.
+     * The caller is responsible for making sure that different blocks
+     * do not write to the same memory.
+     *
+     * @param begin         First index of the range.
+     * @param end           One past the last index of the range.
+     * @param block_size    Number of indices in each block.
+     * @param n_threads     Number of threads to use.
+     * @param fn            Function to call on each block.
+     */
+    template<typename Fn>
+    void parallel_for_blocks(std::size_t begin, std::size_t end, std::size_t block_size, std::size_t n_threads, Fn&& fn) {
+        if(begin >= end) { return; }
+
+        block_size = std::max<std::size_t>(block_size, 1u);
+
+        const std::size_t n_blocks = (end - begin + block_size - 1u) / block_size;
+        n_threads = std::max<std::size_t>(1u, std::min(n_threads, n_blocks));
+
+        std::atomic<std::size_t> next_block{0u};
+
+        auto worker = [&] () {
+            for(auto block = next_block++; block < n_blocks; block = next_block++) {
+                const auto block_begin = begin + block * block_size;
+                const auto block_end = std::min(end, block_begin + block_size);
+
+                fn(block_begin, block_end);
+            }
+        };
+
+        if(n_threads == 1u) {
+            worker();
+            return;
+        }
+
+        std::vector<std::thread> threads;
+        threads.reserve(n_threads - 1u);
+
+        for(auto i = 1u; i < n_threads; ++i) {
+            threads.emplace_back(worker);
+        }
+
+        worker();
+
+        for(auto& thread : threads) {
+            thread.join();
+        }
+    }
+}
+
+#endif //OP_PARALLELFOR_H
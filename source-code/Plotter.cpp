@@ -73,7 +73,7 @@ namespace op {
         };
 
         Clustering c(&graph);
-        std::vector<BoostVertex> clustered;
+        VertexList clustered;
 
         for(auto k = 0u; k < c.n_clusters; ++k) {
             const auto colour = colours[k % colours.size()];
@@ -127,9 +127,11 @@ namespace op {
         const unsigned char red[] = { 255, 0, 0 };
         // const unsigned char black[] = { 0, 0, 0 };
 
-        for(const auto& edge : tour.edges) {
-            const auto v_orig = boost::source(edge, graph.g);
-            const auto v_dest = boost::target(edge, graph.g);
+        const auto& vertices = tour.vertices;
+
+        for(auto i = 0u; vertices.size() > 1u && i < vertices.size(); ++i) {
+            const auto v_orig = vertices[i];
+            const auto v_dest = vertices[(i + 1u) % vertices.size()];
             const auto x_orig = get_x(v_orig), y_orig = get_y(v_orig);
             const auto x_dest = get_x(v_dest), y_dest = get_y(v_dest);
 
@@ -0,0 +1,76 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#ifndef OP_PROXIMITYMAP_H
+#define OP_PROXIMITYMAP_H
+
+#include <cassert>
+#include <cstddef>
+#include "Buffer.h"
+#include "GraphTypes.h"
+
+namespace op {
+    /**
+     * A neighbour in the proximity map.
+     */
+    struct ProximityMapEntry {
+        /**
+         * The neighbouring vertex.
+         */
+        VertexIndex vertex;
+
+        /**
+         * Travel time to the neighbouring vertex.
+         */
+        float travel_time;
+    };
+
+    /**
+     * Associates to each vertex its closest neighbours, ordered by
+     * proximity. All lists are stored contiguously in compressed sparse
+     * row format: the neighbours of vertex v are entries[offsets[v]],
+     * ..., entries[offsets[v + 1] - 1].
+     */
+    struct ProximityMap {
+        /**
+         * Contiguous range of neighbours of a vertex.
+         */
+        struct Neighbours {
+            const ProximityMapEntry* first;
+            const ProximityMapEntry* last;
+
+            const ProximityMapEntry* begin() const { return first; }
+            const ProximityMapEntry* end() const { return last; }
+            std::size_t size() const { return static_cast<std::size_t>(last - first); }
+            bool empty() const { return first == last; }
+            const ProximityMapEntry& front() const { assert(!empty()); return *first; }
+            const ProximityMapEntry& back() const { assert(!empty()); return *(last - 1); }
+            const ProximityMapEntry& operator[](std::size_t i) const { assert(i < size()); return first[i]; }
+        };
+
+        /**
+         * Position in entries of the first neighbour of each vertex.
+         * It has one more element than the number of vertices.
+         */
+        Buffer<std::size_t> offsets;
+
+        /**
+         * Neighbours of all vertices, one list after the other.
+         */
+        Buffer<ProximityMapEntry> entries;
+
+        /**
+         * Gives the neighbours of a vertex.
+         *
+         * @param v The vertex.
+         * @return  Its neighbours, ordered by proximity.
+         */
+        Neighbours operator[](BoostVertex v) const {
+            assert(v + 1u < offsets.size());
+            return {entries.data() + offsets[v], entries.data() + offsets[v + 1u]};
+        }
+    };
+}
+
+#endif //OP_PROXIMITYMAP_H
@@ -7,12 +7,14 @@
 #include <as/console.h>
 #include <as/graph.h>
 #include <as/and_die.h>
+#include <algorithm>
+#include <limits>
 
 namespace op {
     namespace bg = boost::geometry;
-    namespace bgi = boost::geometry::index;
 
-    std::vector<BoostTreeValue> within_radius(const BoostPoint& centre, float radius, const BoostRTree& r) {
+    template<typename Index>
+    std::vector<BoostTreeValue> within_radius(const BoostPoint& centre, float radius, const Index& r) {
         std::vector<BoostTreeValue> results;
 
         // If we simply listed all points and checked their distance from the centre, we would have
@@ -27,17 +29,18 @@ namespace op {
             BoostPoint(centre.x() + radius, centre.y() + radius)
         );
 
-        r.query(
-            bgi::within(bounding) &&
-            bgi::satisfies([&] (const BoostTreeValue& value) { return bg::distance(centre, value.first) <= radius; }) &&
-            bgi::satisfies([] (const BoostTreeValue& value) { return value.second != 0u; }), // Exclude the depot
-            std::back_inserter(results)
-        );
+        for_each_within(r, bounding, [&] (const BoostTreeValue& value) {
+            // Exclude the depot.
+            if(value.second != 0u && bg::distance(centre, value.first) <= radius) {
+                results.push_back(value);
+            }
+        });
 
         return results;
     }
 
-    std::vector<BoostTreeValue> within_radii(const BoostPoint& centre, float min_r, float max_r, const BoostRTree& r) {
+    template<typename Index>
+    std::vector<BoostTreeValue> within_radii(const BoostPoint& centre, float min_r, float max_r, const Index& r) {
         std::vector<BoostTreeValue> results;
 
         float side = min_r / M_SQRT2;
@@ -52,20 +55,27 @@ namespace op {
             BoostPoint(centre.x() + max_r, centre.y() + max_r)
         );
 
-        r.query(
-            bgi::within(outer) &&
-            bgi::disjoint(inner) &&
-            bgi::satisfies([&] (const BoostTreeValue& value) { return bg::distance(centre, value.first) <= max_r; }) &&
-            bgi::satisfies([&] (const BoostTreeValue& value) { return bg::distance(centre, value.first) >= min_r; }) &&
-            bgi::satisfies([] (const BoostTreeValue& value) { return value.second != 0u; }), // Exclude the depot
-            std::back_inserter(results)
-        );
+        for_each_within(r, outer, [&] (const BoostTreeValue& value) {
+            // Exclude the depot.
+            if(value.second == 0u || !bg::disjoint(value.first, inner)) { return; }
+
+            const auto distance = bg::distance(centre, value.first);
+
+            if(distance <= max_r && distance >= min_r) {
+                results.push_back(value);
+            }
+        });
 
         return results;
     }
 
-    std::vector<std::vector<BoostVertex>> dbscan(const Graph& g, float radius, std::size_t min_pts) {
-        using Cluster = std::vector<BoostVertex>;
+    std::vector<VertexList> dbscan(const Graph& g, float radius, std::size_t min_pts) {
+        return dbscan(g, g.spatial_index, radius, min_pts);
+    }
+
+    template<typename Index>
+    std::vector<VertexList> dbscan(const Graph& g, const Index& index, float radius, std::size_t min_pts) {
+        using Cluster = VertexList;
         const auto n_vertices = boost::num_vertices(g.g);
 
         std::vector<Cluster> clustering;
@@ -81,7 +91,7 @@ namespace op {
         for(auto i = 1u; i < n_vertices; ++i) {
             // We don't care about unreachable vertices, so we just
             // label them as noise from the beginning.
-            label[i] = (g.g[i].reachable ? LabelUndefined : LabelNoise);
+            label[i] = (g.is_reachable(i) ? LabelUndefined : LabelNoise);
         }
 
         for(auto i = 1u; i < n_vertices; ++i) {
@@ -91,7 +101,7 @@ namespace op {
             const auto& v = g.g[i];
             const auto pt = BoostPoint(v.x, v.y);
             const auto pt_val = std::make_pair(pt, i);
-            auto neighbours = within_radius(pt, radius, g.rtree);
+            auto neighbours = within_radius(pt, radius, index);
 
             // Not enough neighbours: mark as an outlier (noise).
             if(neighbours.size() < min_pts) {
@@ -126,14 +136,14 @@ namespace op {
                 }
 
                 // Skip unreachable vertices.
-                if(!g.g[j].reachable) { continue; }
+                if(!g.is_reachable(j)) { continue; }
 
                 if(label[j] == LabelNoise) { label[j] = current_cluster; }
                 if(label[j] != LabelUndefined) { continue; }
 
                 label[j] = current_cluster;
 
-                const auto further_neighbours = within_radius(qt, radius, g.rtree);
+                const auto further_neighbours = within_radius(qt, radius, index);
 
                 if(further_neighbours.size() >= min_pts) {
                     for(const auto& n : further_neighbours) {
@@ -170,7 +180,7 @@ namespace op {
         assert(std::all_of(
            clustering.begin(),
            clustering.end(),
-           [min_pts] (const std::vector<BoostVertex>& cluster) -> bool {
+           [min_pts] (const VertexList& cluster) -> bool {
                return cluster.size() >= min_pts;
            }
         ));
@@ -180,7 +190,14 @@ namespace op {
         return clustering;
     }
 
-    std::vector<std::vector<BoostVertex>> dbscan(const Graph& g) {
+    std::vector<VertexList> dbscan(const Graph& g) {
+        const auto parameters = dbscan_parameters(g);
+
+        // Finally, we run the clustering algorithm with these parameters.
+        return dbscan(g, parameters.first, parameters.second);
+    }
+
+    std::pair<float, std::size_t> dbscan_parameters(const Graph& g) {
         // Get the distance of each vertex to its nearest neighbour.
         const auto distances = nearest_neighbour_distances(g);
 
@@ -250,29 +267,29 @@ namespace op {
 
         std::cout << as::console::notice << "DBSCAN auto-tuned min_pts: " << min_pts << std::endl;
 
-        // Finally, we run the clustering algorithm with these parameters.
-        return dbscan(g, radius, min_pts);
+        return std::make_pair(radius, min_pts);
     }
 
     std::vector<float> nearest_neighbour_distances(const Graph& g) {
         std::vector<float> dist;
 
         for(const auto& vertex : as::graph::vertices(g.g)) {
-            const auto out_edges = as::graph::out_edges(vertex, g.g);
+            auto shortest = std::numeric_limits<float>::max();
+            bool has_neighbours = false;
+
+            for(const auto& other : as::graph::vertices(g.g)) {
+                if(!g.has_edge(vertex, other)) { continue; }
 
-            if(out_edges.begin() == out_edges.end()) {
+                shortest = std::min(shortest, g.travel_time(vertex, other));
+                has_neighbours = true;
+            }
+
+            if(!has_neighbours) {
                 // No neighbours.
                 continue;
             }
 
-            const auto shortest_edge = *std::min_element(
-                  out_edges.begin(),
-                  out_edges.end(),
-                  [&g] (const BoostEdge& e1, const BoostEdge& e2) -> bool {
-                      return g.g[e1].travel_time < g.g[e2].travel_time;
-                  });
-
-            dist.push_back(g.g[shortest_edge].travel_time);
+            dist.push_back(shortest);
         }
 
         std::sort(dist.begin(), dist.end());
@@ -285,7 +302,7 @@ namespace op {
 
         for(const auto& vertex : as::graph::vertices(g.g)) {
             const auto& vprop = g.g[vertex];
-            const auto nb = within_radius(BoostPoint(vprop.x, vprop.y), radius, g.rtree);
+            const auto nb = within_radius(BoostPoint(vprop.x, vprop.y), radius, g.spatial_index);
 
             std::size_t nb_size = 0u;
 
@@ -307,4 +324,20 @@ namespace op {
 
         return sizes;
     }
+
+    // Instantiate the queries for all the spatial indices, so that they can be benchmarked.
+    template std::vector<BoostTreeValue> within_radius(const BoostPoint&, float, const RStarRTree&);
+    template std::vector<BoostTreeValue> within_radius(const BoostPoint&, float, const LinearRTree&);
+    template std::vector<BoostTreeValue> within_radius(const BoostPoint&, float, const QuadraticRTree&);
+    template std::vector<BoostTreeValue> within_radius(const BoostPoint&, float, const UniformGrid&);
+
+    template std::vector<BoostTreeValue> within_radii(const BoostPoint&, float, float, const RStarRTree&);
+    template std::vector<BoostTreeValue> within_radii(const BoostPoint&, float, float, const LinearRTree&);
+    template std::vector<BoostTreeValue> within_radii(const BoostPoint&, float, float, const QuadraticRTree&);
+    template std::vector<BoostTreeValue> within_radii(const BoostPoint&, float, float, const UniformGrid&);
+
+    template std::vector<VertexList> dbscan(const Graph&, const RStarRTree&, float, std::size_t);
+    template std::vector<VertexList> dbscan(const Graph&, const LinearRTree&, float, std::size_t);
+    template std::vector<VertexList> dbscan(const Graph&, const QuadraticRTree&, float, std::size_t);
+    template std::vector<VertexList> dbscan(const Graph&, const UniformGrid&, float, std::size_t);
 }
@@ -5,29 +5,34 @@
 #ifndef OP_RTREEUTILS_H
 #define OP_RTREEUTILS_H
 
+#include <utility>
 #include "Graph.h"
 
 namespace op {
     /**
      * Returns a list of points which are within a certain radius from the centre.
      *
+     * @tparam Index     The spatial index type.
      * @param centre    The centre point.
      * @param radius    The radius.
-     * @param t         The RTree on which to perform the search.
+     * @param r         The spatial index on which to perform the search.
      * @return          A list of points within distance "radius" from "centre" (including itself).
      */
-    std::vector<BoostTreeValue> within_radius(const BoostPoint& centre, float radius, const BoostRTree& r);
+    template<typename Index>
+    std::vector<BoostTreeValue> within_radius(const BoostPoint& centre, float radius, const Index& r);
 
     /**
      * Return a list of points which are within a minimum and a maximum radius from the centre.
      *
+     * @tparam Index     The spatial index type.
      * @param centre    The centre point.
      * @param min_r     Min distance from the centre.
      * @param max_r     Max distance from the centre.
-     * @param r         The RTree on which to perform the search.
+     * @param r         The spatial index on which to perform the search.
      * @return          A list of points satisfying the requisites.s
      */
-    std::vector<BoostTreeValue> within_radii(const BoostPoint& centre, float min_r, float max_r, const BoostRTree& r);
+    template<typename Index>
+    std::vector<BoostTreeValue> within_radii(const BoostPoint& centre, float min_r, float max_r, const Index& r);
 
     /**
      * Runs the DBSCAN clustering algorithm on the graph.
@@ -37,7 +42,21 @@ namespace op {
      * @param min_pts   Minimum number of points to create a cluster.
      * @return          A clustering of the graph's vertices (not a partition, as some vertex might be left out).
      */
-    std::vector<std::vector<BoostVertex>> dbscan(const Graph& g, float radius, std::size_t min_pts);
+    std::vector<VertexList> dbscan(const Graph& g, float radius, std::size_t min_pts);
+
+    /**
+     * Runs the DBSCAN clustering algorithm on the graph, using a given
+     * spatial index of its vertices rather than the graph's own.
+     *
+     * @tparam Index    The spatial index type.
+     * @param g         The graph.
+     * @param index     The spatial index of the graph's vertices.
+     * @param radius    Neighbours of a vertex are searched within this radius.
+     * @param min_pts   Minimum number of points to create a cluster.
+     * @return          A clustering of the graph's vertices (not a partition, as some vertex might be left out).
+     */
+    template<typename Index>
+    std::vector<VertexList> dbscan(const Graph& g, const Index& index, float radius, std::size_t min_pts);
 
     /**
      * Runs the DBSCAN clustering algorithm with the radius and min_pts parameter obtained
@@ -46,7 +65,16 @@ namespace op {
      * @param g The graph.
      * @return  A clustering of the graph's vertices (not a partition, as some vertex might be left out).
      */
-    std::vector<std::vector<BoostVertex>> dbscan(const Graph& g);
+    std::vector<VertexList> dbscan(const Graph& g);
+
+    /**
+     * Guesses the radius and min_pts parameters of DBSCAN for a graph,
+     * from the distribution of the distances between its vertices.
+     *
+     * @param g The graph.
+     * @return  The radius and the min_pts parameters.
+     */
+    std::pair<float, std::size_t> dbscan_parameters(const Graph& g);
 
     /**
      * Returns a vector containing the distances from each vertex of the
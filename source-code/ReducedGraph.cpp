@@ -9,10 +9,52 @@
 #include <as/containers.h>
 
 namespace op {
-    ReducedGraph::ReducedGraph(const Graph *const original_graph) :
-        ReducedGraph(original_graph, Clustering(original_graph)) {}
+    // Reduced graphs need to modify their travel times, so they cannot
+    // compute them on the fly from the vertex coordinates. They are also
+    // small, so we can afford to store their edges.
+    static GraphOptions reduced_graph_options(const Graph& original_graph) {
+        GraphOptions options = original_graph.options;
+        options.materialise_edges = true;
+
+        // Travel times are replaced by those of the clusters, so the pruning would not be valid.
+        options.prune_infeasible_edges = false;
+
+        if(DistanceOracle::needs_coordinates(options.distance_storage)) {
+            options.distance_storage = DistanceOracle::Backend::TriangularMatrix;
+        }
+
+        return options;
+    }
+
+    // Adds the travel time of the clusters to those of the reduced graph. Each
+    // edge incident to a cluster gets half of that cluster's tsp travel time,
+    // so that when a vertex is visited (by two incident edges) the whole travel
+    // time is considered.
+    static void add_cluster_travel_times(Graph& reduced_graph, const std::map<BoostVertex, Tour>& tsps, std::size_t n_clusters) {
+        for(auto origin = 0u; origin < reduced_graph.n_vertices; ++origin) {
+            for(auto destination = origin + 1u; destination < reduced_graph.n_vertices; ++destination) {
+                if(!reduced_graph.has_edge(origin, destination)) { continue; }
+
+                auto travel_time = reduced_graph.travel_time(origin, destination);
+
+                if(1u <= origin && origin <= n_clusters) {
+                    travel_time += tsps.at(origin).travel_time / 2.0f;
+                }
+
+                if(1u <= destination && destination <= n_clusters) {
+                    travel_time += tsps.at(destination).travel_time / 2.0f;
+                }
+
+                reduced_graph.distances.set(origin, destination, travel_time);
+                reduced_graph.g[reduced_graph.edge(origin, destination)].travel_time = travel_time;
+            }
+        }
+    }
+
+    ReducedGraph::ReducedGraph(const Graph *const original_graph, const LinKernighanOptions& tsp_options) :
+        ReducedGraph(original_graph, Clustering(original_graph), tsp_options) {}
 
-    ReducedGraph::ReducedGraph(const Graph *const original_graph, const Clustering& c) :
+    ReducedGraph::ReducedGraph(const Graph *const original_graph, const Clustering& c, const LinKernighanOptions& tsp_options) :
         original_graph{std::experimental::make_observer(original_graph)}
     {
         std::vector<Vertex> vertices;
@@ -35,7 +77,7 @@ namespace op {
             assert(c.clusters[k].size() > 1u);
 
             vertices_mapping[k + 1] = c.clusters[k];
-            tsps[k + 1] = run_lin_kernighan(*original_graph, vertices_mapping[k + 1]);
+            tsps[k + 1] = run_lin_kernighan(*original_graph, vertices_mapping[k + 1], tsp_options);
 
             // Check that tsp and vertex mapping are consistent
             assert(
@@ -50,40 +92,24 @@ namespace op {
         for(const auto& vertex : c.noise) {
             auto vprop = original_graph->g[vertex];
 
-            vertices_mapping[vertex_id] = {vprop.id};
+            vertices_mapping[vertex_id] = {static_cast<VertexIndex>(vprop.id)};
 
             vprop.id = vertex_id++;
             vertices.push_back(vprop);
         }
 
         // Creates the Graph object for the reduced graph.
-        reduced_graph = Graph(vertices, original_graph->max_travel_time);
-
-        // Add the travel time to the edges. Each edge incident to
-        // a cluster gets half of that cluster's tsp travel time,
-        // so that when a vertex is visited (by two incident edges)
-        // the whole travel time is considered.
-        for(const auto& edge : as::graph::edges(reduced_graph.g)) {
-            auto& eprop = reduced_graph.g[edge];
-            const auto& origin = boost::source(edge, reduced_graph.g);
-            const auto& destination = boost::target(edge, reduced_graph.g);
-
-            if(1u <= origin && origin <= c.n_clusters) {
-                eprop.travel_time += tsps[origin].travel_time / 2.0f;
-            }
+        reduced_graph = Graph(vertices, original_graph->max_travel_time, reduced_graph_options(*original_graph));
 
-            if(1u <= destination && destination <= c.n_clusters) {
-                eprop.travel_time += tsps[destination].travel_time / 2.0f;
-            }
-        }
+        add_cluster_travel_times(reduced_graph, tsps, c.n_clusters);
     }
 
-    ReducedGraph reduce_again(const ReducedGraph& other) {
+    ReducedGraph reduce_again(const ReducedGraph& other, const LinKernighanOptions& tsp_options) {
         Clustering c(&(other.reduced_graph));
-        return reduce_again(other, c);
+        return reduce_again(other, c, tsp_options);
     }
 
-    ReducedGraph reduce_again(const ReducedGraph& other, const Clustering& c) {
+    ReducedGraph reduce_again(const ReducedGraph& other, const Clustering& c, const LinKernighanOptions& tsp_options) {
         ReducedGraph new_red;
         new_red.original_graph = other.original_graph;
 
@@ -110,7 +136,7 @@ namespace op {
                 }
             }
 
-            new_red.tsps[k + 1] = run_lin_kernighan(*new_red.original_graph, new_red.vertices_mapping[k + 1]);
+            new_red.tsps[k + 1] = run_lin_kernighan(*new_red.original_graph, new_red.vertices_mapping[k + 1], tsp_options);
 
             // Check that tsp and vertex mapping are consistent
             assert(
@@ -146,35 +172,19 @@ namespace op {
             ++vertex_id;
         }
 
-        new_red.reduced_graph = Graph(vertices, new_red.original_graph->max_travel_time);
+        new_red.reduced_graph = Graph(vertices, new_red.original_graph->max_travel_time, reduced_graph_options(*new_red.original_graph));
 
-        // Add the travel time to the edges. Each edge incident to
-        // a cluster gets half of that cluster's tsp travel time,
-        // so that when a vertex is visited (by two incident edges)
-        // the whole travel time is considered.
-        for(const auto& edge : as::graph::edges(new_red.reduced_graph.g)) {
-            auto& eprop = new_red.reduced_graph.g[edge];
-            const auto& origin = boost::source(edge, new_red.reduced_graph.g);
-            const auto& destination = boost::target(edge, new_red.reduced_graph.g);
-
-            if(1u <= origin && origin <= c.n_clusters) {
-                eprop.travel_time += new_red.tsps[origin].travel_time / 2.0f;
-            }
-
-            if(1u <= destination && destination <= c.n_clusters) {
-                eprop.travel_time += new_red.tsps[destination].travel_time / 2.0f;
-            }
-        }
+        add_cluster_travel_times(new_red.reduced_graph, new_red.tsps, c.n_clusters);
 
         return new_red;
     }
 
-    std::optional<ReducedGraph> recursive_reduction(const Graph *const graph, float red_factor) {
+    std::optional<ReducedGraph> recursive_reduction(const Graph *const graph, float red_factor, const LinKernighanOptions& tsp_options) {
         Clustering c(graph);
 
         if(!c.is_proper()) { return std::nullopt; }
 
-        ReducedGraph red(graph, c);
+        ReducedGraph red(graph, c, tsp_options);
 
         std::size_t limit_n_vertices = std::min(
             static_cast<std::size_t>(red.original_graph->n_vertices * red_factor),
@@ -197,7 +207,7 @@ namespace op {
             }
 
             // Else, reduce again.
-            ReducedGraph red_again = reduce_again(red, c);
+            ReducedGraph red_again = reduce_again(red, c, tsp_options);
 
             red = red_again;
         }
@@ -252,7 +262,7 @@ namespace op {
 
         assert(tour.is_simple());
 
-        std::vector<BoostVertex> vertices;
+        SmallVertexList vertices;
         const Graph& g = *(red.original_graph);
         const Graph& r = red.reduced_graph;
 
@@ -7,6 +7,7 @@
 
 #include "Graph.h"
 #include "Clustering.h"
+#include "LinKernighan.h"
 #include <experimental/memory>
 #include <map>
 #include <optional>
@@ -27,7 +28,7 @@ namespace op {
          * A mapping of the new vertex numbering (in the reduced graph)
          * to the original one (in the original graph).
          */
-        std::map<BoostVertex, std::vector<BoostVertex>> vertices_mapping;
+        std::map<BoostVertex, VertexList> vertices_mapping;
 
         /**
          * TSPs for those points which are mapped to > 1 vertex on the
@@ -44,8 +45,9 @@ namespace op {
          * Builds the reduced graph from an (original) graph.
          *
          * @param original_graph The original graph.
+         * @param tsp_options    Options of the TSP heuristic used on the clusters.
          */
-        explicit ReducedGraph(const Graph *const original_graph);
+        explicit ReducedGraph(const Graph *const original_graph, const LinKernighanOptions& tsp_options = LinKernighanOptions());
 
         /**
          * Builds the reduced graph from an (original) graph, when
@@ -54,8 +56,9 @@ namespace op {
          *
          * @param original_graph    The original graph.
          * @param c                 A clustering for the original graph.
+         * @param tsp_options       Options of the TSP heuristic used on the clusters.
          */
-        ReducedGraph(const Graph *const original_graph, const Clustering& c);
+        ReducedGraph(const Graph *const original_graph, const Clustering& c, const LinKernighanOptions& tsp_options = LinKernighanOptions());
 
         /**
          * Applies clustering reduction recursively on a given Graph.
@@ -64,9 +67,11 @@ namespace op {
          * least red_factor. If no proper clustering is possible already
          * for the original graph, it returns std::nullopt.
          *
-         * @param graph The original graph.
+         * @param graph       The original graph.
+         * @param red_factor  The reduction factor.
+         * @param tsp_options Options of the TSP heuristic used on the clusters.
          */
-        friend std::optional<ReducedGraph> recursive_reduction(const Graph *const graph, float red_factor);
+        friend std::optional<ReducedGraph> recursive_reduction(const Graph *const graph, float red_factor, const LinKernighanOptions& tsp_options);
 
         /**
          * Takes a tour on the reduced graph and builds a tour on the
@@ -87,26 +92,28 @@ namespace op {
         /**
          * Reduces again an already reduced graph.
          *
-         * @param other The reduced graph to reduce again.
-         * @return      The re-reduced graph.
+         * @param other       The reduced graph to reduce again.
+         * @param tsp_options Options of the TSP heuristic used on the clusters.
+         * @return            The re-reduced graph.
          */
-        friend ReducedGraph reduce_again(const ReducedGraph& other);
+        friend ReducedGraph reduce_again(const ReducedGraph& other, const LinKernighanOptions& tsp_options);
 
         /**
          * Reduces again an already reduced graph, when a
          * clustering for the already-reduced graph is available.
          *
-         * @param other The reduced graph to reduce again.
-         * @param c     A clustering for the reduced graph.
-         * @return      The re-reduced graph.
+         * @param other       The reduced graph to reduce again.
+         * @param c           A clustering for the reduced graph.
+         * @param tsp_options Options of the TSP heuristic used on the clusters.
+         * @return            The re-reduced graph.
          */
-        friend ReducedGraph reduce_again(const ReducedGraph& other, const Clustering& c);
+        friend ReducedGraph reduce_again(const ReducedGraph& other, const Clustering& c, const LinKernighanOptions& tsp_options);
     };
 
-    std::optional<ReducedGraph> recursive_reduction(const Graph *const graph, float red_factor = 0.5f);
+    std::optional<ReducedGraph> recursive_reduction(const Graph *const graph, float red_factor = 0.5f, const LinKernighanOptions& tsp_options = LinKernighanOptions());
     Tour project_back_tour(const Tour& tour, const ReducedGraph& red);
-    ReducedGraph reduce_again(const ReducedGraph& other);
-    ReducedGraph reduce_again(const ReducedGraph& other, const Clustering& c);
+    ReducedGraph reduce_again(const ReducedGraph& other, const LinKernighanOptions& tsp_options = LinKernighanOptions());
+    ReducedGraph reduce_again(const ReducedGraph& other, const Clustering& c, const LinKernighanOptions& tsp_options = LinKernighanOptions());
 }
 
 #endif //OP_REDUCEDGRAPH_H
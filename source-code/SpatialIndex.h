@@ -0,0 +1,79 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#ifndef OP_SPATIALINDEX_H
+#define OP_SPATIALINDEX_H
+
+#include <utility>
+#include <boost/iterator/function_output_iterator.hpp>
+#include "GraphTypes.h"
+#include "UniformGrid.h"
+
+namespace op {
+    /**
+     * R-tree with R-star node splitting.
+     */
+    using RStarRTree = BoostRTree;
+
+    /**
+     * R-tree with linear node splitting: faster to build by insertion, slower to query.
+     */
+    using LinearRTree = boost::geometry::index::rtree<BoostTreeValue, boost::geometry::index::linear<16, 4>>;
+
+    /**
+     * R-tree with quadratic node splitting.
+     */
+    using QuadraticRTree = boost::geometry::index::rtree<BoostTreeValue, boost::geometry::index::quadratic<16, 4>>;
+
+    /**
+     * Spatial index used by the graph to answer the range queries of
+     * the heuristics and of the clustering. It is chosen at compile time
+     * by defining one of OP_SPATIAL_INDEX_LINEAR, OP_SPATIAL_INDEX_QUADRATIC,
+     * or OP_SPATIAL_INDEX_GRID; by default, it is an R-star r-tree. All
+     * indices are bulk-loaded from a range of points (r-trees use their
+     * STR-like packing algorithm). Use the bench-spatial action to compare them
+     * on an instance.
+     */
+#if defined(OP_SPATIAL_INDEX_GRID)
+    using SpatialIndex = UniformGrid;
+#elif defined(OP_SPATIAL_INDEX_QUADRATIC)
+    using SpatialIndex = QuadraticRTree;
+#elif defined(OP_SPATIAL_INDEX_LINEAR)
+    using SpatialIndex = LinearRTree;
+#else
+    using SpatialIndex = RStarRTree;
+#endif
+
+    /**
+     * Calls fn(value) for each point of an r-tree strictly inside a box.
+     *
+     * @tparam Params   The r-tree parameters.
+     * @tparam Fn       Type of the function.
+     * @param  index    The r-tree.
+     * @param  box      The box.
+     * @param  fn       The function.
+     */
+    template<typename Params, typename Fn>
+    void for_each_within(const boost::geometry::index::rtree<BoostTreeValue, Params>& index, const BoostBox& box, Fn&& fn) {
+        index.query(
+            boost::geometry::index::within(box),
+            boost::make_function_output_iterator([&fn] (const BoostTreeValue& value) { fn(value); })
+        );
+    }
+
+    /**
+     * Calls fn(value) for each point of a uniform grid strictly inside a box.
+     *
+     * @tparam Fn       Type of the function.
+     * @param  index    The grid.
+     * @param  box      The box.
+     * @param  fn       The function.
+     */
+    template<typename Fn>
+    void for_each_within(const UniformGrid& index, const BoostBox& box, Fn&& fn) {
+        index.for_each_within(box, std::forward<Fn>(fn));
+    }
+}
+
+#endif //OP_SPATIALINDEX_H
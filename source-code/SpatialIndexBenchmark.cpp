@@ -0,0 +1,141 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#include "SpatialIndexBenchmark.h"
+#include "RTreeUtils.h"
+
+#include <as/console.h>
+#include <as/graph.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace op {
+    namespace {
+        using Clock = std::chrono::high_resolution_clock;
+
+        float seconds_since(Clock::time_point start) {
+            return std::chrono::duration_cast<std::chrono::duration<float>>(Clock::now() - start).count();
+        }
+
+        /**
+         * Result of the benchmark of one index.
+         */
+        struct SpatialIndexTimes {
+            float build;
+            float within_radius;
+            float within_radii;
+            float dbscan;
+
+            // Total number of points returned by the queries, to check
+            // that all indices give the same results.
+            std::size_t radius_points;
+            std::size_t radii_points;
+            std::size_t clustered_points;
+        };
+
+        template<typename Index>
+        Index bulk_load(const std::vector<BoostTreeValue>& values) {
+            return Index(values.begin(), values.end());
+        }
+
+        template<typename Index>
+        Index insert_one_at_a_time(const std::vector<BoostTreeValue>& values) {
+            Index index;
+
+            for(const auto& value : values) {
+                index.insert(value);
+            }
+
+            return index;
+        }
+
+        template<typename Index>
+        SpatialIndexTimes run_benchmark(const Graph& graph, const std::vector<BoostTreeValue>& values,
+                                        Index(*build)(const std::vector<BoostTreeValue>&), float radius,
+                                        const std::pair<float, std::size_t>& dbscan_parameters) {
+            SpatialIndexTimes times{};
+
+            auto start = Clock::now();
+            const auto index = build(values);
+            times.build = seconds_since(start);
+
+            start = Clock::now();
+            for(const auto& value : values) {
+                times.radius_points += within_radius(value.first, radius, index).size();
+            }
+            times.within_radius = seconds_since(start);
+
+            start = Clock::now();
+            for(const auto& value : values) {
+                times.radii_points += within_radii(value.first, radius, 2.0f * radius, index).size();
+            }
+            times.within_radii = seconds_since(start);
+
+            start = Clock::now();
+            for(const auto& cluster : dbscan(graph, index, dbscan_parameters.first, dbscan_parameters.second)) {
+                times.clustered_points += cluster.size();
+            }
+            times.dbscan = seconds_since(start);
+
+            return times;
+        }
+    }
+
+    void benchmark_spatial_indices(const Graph& graph) {
+        using namespace as::console;
+
+        std::vector<BoostTreeValue> values;
+        values.reserve(graph.n_vertices);
+
+        for(const auto& vertex : as::graph::vertices(graph.g)) {
+            values.emplace_back(BoostPoint(graph.vertex_arrays.xs[vertex], graph.vertex_arrays.ys[vertex]), vertex);
+        }
+
+        // A disc of this radius contains about 10 vertices, if they are spread evenly.
+        const auto area = std::max((graph.max_x - graph.min_x) * (graph.max_y - graph.min_y), 1e-6f);
+        const auto radius = std::sqrt(10.0f * area / (static_cast<float>(M_PI) * graph.n_vertices));
+
+        // Use the same parameters as the clustering of the graph.
+        const auto parameters = dbscan_parameters(graph);
+
+        std::cout << notice << "Benchmarking spatial indices on " << values.size() << " vertices, with radius " << radius << std::endl;
+
+        const std::vector<std::pair<std::string, SpatialIndexTimes>> results = {
+            {"rstar-insert", run_benchmark(graph, values, insert_one_at_a_time<RStarRTree>, radius, parameters)},
+            {"rstar-packed", run_benchmark(graph, values, bulk_load<RStarRTree>, radius, parameters)},
+            {"linear-insert", run_benchmark(graph, values, insert_one_at_a_time<LinearRTree>, radius, parameters)},
+            {"linear-packed", run_benchmark(graph, values, bulk_load<LinearRTree>, radius, parameters)},
+            {"quadratic-insert", run_benchmark(graph, values, insert_one_at_a_time<QuadraticRTree>, radius, parameters)},
+            {"quadratic-packed", run_benchmark(graph, values, bulk_load<QuadraticRTree>, radius, parameters)},
+            {"grid", run_benchmark(graph, values, bulk_load<UniformGrid>, radius, parameters)}
+        };
+
+        const auto& reference = results.front().second;
+
+        for(const auto& result : results) {
+            const auto& name = result.first;
+            const auto& times = result.second;
+            const auto queries = static_cast<float>(values.size());
+
+            std::cout << notice << name << ": build " << times.build << "s, ";
+            std::cout << "within_radius " << queries / times.within_radius << " queries/s, ";
+            std::cout << "within_radii " << queries / times.within_radii << " queries/s, ";
+            std::cout << "dbscan " << times.dbscan << "s" << std::endl;
+
+            if(times.radius_points != reference.radius_points ||
+               times.radii_points != reference.radii_points ||
+               times.clustered_points != reference.clustered_points)
+            {
+                std::cout << warning << name << " gave different results from " << results.front().first << std::endl;
+            }
+
+            std::cerr << graph.instance_name() << "," << name << "," << times.build << ",";
+            std::cerr << times.within_radius << "," << times.within_radii << "," << times.dbscan << "\n";
+        }
+    }
+}
@@ -0,0 +1,26 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#ifndef OP_SPATIALINDEXBENCHMARK_H
+#define OP_SPATIALINDEXBENCHMARK_H
+
+#include "Graph.h"
+
+namespace op {
+    /**
+     * Compares the spatial indices of SpatialIndex.h on the vertices of a
+     * graph: for each index, and each way of building it (bulk loading or
+     * one insertion at a time), it measures the construction time and the
+     * throughput of within_radius and within_radii (with a radius such that
+     * each disc contains about ten vertices, on average), and the time
+     * taken by dbscan, with auto-tuned parameters. Results are printed on
+     * the console, and one CSV line per index is printed on the standard
+     * error.
+     *
+     * @param graph The graph.
+     */
+    void benchmark_spatial_indices(const Graph& graph);
+}
+
+#endif //OP_SPATIALINDEXBENCHMARK_H
@@ -4,7 +4,7 @@
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
-#include <boost/graph/r_c_shortest_paths.hpp>
+#include <boost/heap/d_ary_heap.hpp>
 #include <as/file_stream.h>
 #include <as/containers.h>
 #include <as/console.h>
@@ -20,20 +20,20 @@
 namespace op {
     namespace fs = std::experimental::filesystem;
 
-    Tour::Tour(const Graph *const graph, std::vector<BoostEdge> edges) :
-        graph{std::experimental::make_observer(graph)},
-        edges{edges}
+    Tour::Tour(const Graph *const graph, const std::vector<BoostEdge>& edges) :
+        graph{std::experimental::make_observer(graph)}
     {
-        calculate_vertices_from_edges();
+        calculate_vertices_from_edges(edges);
+        index_vertices();
         calculate_travel_time();
         calculate_total_prize();
     }
 
-    Tour::Tour(const Graph *const graph, std::vector<BoostVertex> vertices) :
+    Tour::Tour(const Graph *const graph, SmallVertexList vertices) :
         graph{std::experimental::make_observer(graph)},
         vertices{vertices}
     {
-        calculate_edges_from_vertices();
+        index_vertices();
         calculate_travel_time();
         calculate_total_prize();
     }
@@ -57,6 +57,8 @@ namespace op {
         } else if(ext == ".json") {
             read_from_json(solution_file);
         }
+
+        index_vertices();
     }
 
     void Tour::read_from_json(fs::path solution_file) {
@@ -66,16 +68,19 @@ namespace op {
         ptree t;
         read_json(solution_file, t);
 
+        VertexList ids;
+
         for(const auto& vnode : t.get_child("tour")) {
-            vertices.push_back(vnode.second.get_value<BoostVertex>());
+            ids.push_back(vnode.second.get_value<VertexIndex>());
         }
+
+        const auto tour_vertices = graph->vertices_from_original_ids(ids);
+        vertices.assign(tour_vertices.begin(), tour_vertices.end());
         travel_time = t.get<float>("travel_time");
         total_prize = t.get<float>("prize");
 
         std::cout << notice << "Read solution with " << vertices.size() << " vertices." << std::endl;
 
-        calculate_edges_from_vertices();
-
         assert(is_travel_time_correct());
     }
 
@@ -93,34 +98,43 @@ namespace op {
         skip_lines(ifs, 9u);
 
         long int next_id = 1;
-        std::size_t current_v = 0u; // Start from the depot.
+        VertexList ids;
 
         while(ifs >> next_id) {
-            std::size_t next_v;
-
             if(next_id == -1) {
                 // Tour is over, go back to the depot.
-                next_v = 0u;
+                ids.push_back(0u);
             } else {
                 assert(next_id > 1u);
-                next_v = static_cast<std::size_t>(next_id - 1);
+                ids.push_back(static_cast<VertexIndex>(next_id - 1));
             }
+        }
+
+        vertices.clear();
+        vertices.push_back(0u); // Start from the depot.
 
-            const auto edge_found = boost::edge(current_v, next_v, graph->g);
+        std::size_t n_edges = 0u;
+        std::size_t current_v = 0u;
 
-            if(!edge_found.second) {
+        for(const auto& next_v : graph->vertices_from_original_ids(ids)) {
+            if(!graph->has_edge(current_v, next_v)) {
                 std::cerr << error << "Edge not found from " << current_v << " to " << next_v << and_die();
             }
 
-            edges.push_back(edge_found.first);
+            if(next_v != 0u) { vertices.push_back(next_v); }
+
             current_v = next_v;
+            ++n_edges;
+        }
+
+        if(current_v != 0u) {
+            std::cerr << error << "The tour is not closed!" << and_die();
         }
 
-        calculate_vertices_from_edges();
         calculate_travel_time();
         calculate_total_prize();
 
-        std::cout << notice << "Read solution with " << edges.size() << " edges." << std::endl;
+        std::cout << notice << "Read solution with " << n_edges << " edges." << std::endl;
     }
 
     void Tour::print_to_png(fs::path image_file) const {
@@ -131,7 +145,7 @@ namespace op {
         plotter.plot_tour_to_png(*this, image_file);
     }
 
-    void Tour::calculate_vertices_from_edges() {
+    void Tour::calculate_vertices_from_edges(const std::vector<BoostEdge>& edges) {
         using namespace as::containers;
         using namespace as::graph;
         using namespace as::console;
@@ -163,33 +177,66 @@ namespace op {
         }
     }
 
-    void Tour::calculate_edges_from_vertices() {
-        edges.clear();
+    void Tour::index_vertices() {
+        positions.resize(graph->n_vertices);
+        visited.assign((graph->n_vertices + 63u) / 64u, 0u);
+
+        for(const auto& v : vertices) {
+            visited[v / 64u] |= std::uint64_t{1u} << (v % 64u);
+        }
+
+        update_positions(0u, vertices.size());
+
+        prefix_travel_times.resize(vertices.size());
+        prefix_travel_times[0u] = 0.0f;
+        update_prefix_travel_times(1u, vertices.size());
+    }
+
+    void Tour::update_positions(std::size_t first, std::size_t last) {
+        for(auto i = first; i < last; ++i) {
+            positions[vertices[i]] = static_cast<VertexIndex>(i);
+        }
+    }
+
+    void Tour::update_prefix_travel_times(std::size_t first, std::size_t last) {
+        assert(first > 0u);
+
+        for(auto i = first; i < last; ++i) {
+            prefix_travel_times[i] = prefix_travel_times[i - 1u] + graph->exact_travel_time(vertices[i - 1u], vertices[i]);
+        }
+    }
+
+    void Tour::shift_prefix_travel_times(std::size_t first, float delta) {
+        for(auto i = first; i < prefix_travel_times.size(); ++i) {
+            prefix_travel_times[i] += delta;
+        }
+    }
 
-        if(vertices.size() == 1u) { return; }
+    std::vector<BoostEdge> Tour::edges() const {
+        std::vector<BoostEdge> edges;
+
+        if(vertices.size() == 1u) { return edges; }
 
         edges.reserve(vertices.size());
 
         for(auto i = 0u; i < vertices.size(); ++i) {
             const auto& curr_v = vertices[i];
             const auto& next_v = vertices[(i + 1) % vertices.size()];
-            const auto& edge = boost::edge(curr_v, next_v, graph->g).first;
-            edges.push_back(edge);
+            edges.push_back(graph->edge(curr_v, next_v));
         }
+
+        return edges;
     }
 
     void Tour::calculate_travel_time() {
-        if(edges.empty()) {
+        if(vertices.size() <= 1u) {
             travel_time = 0.0f;
         } else {
-            travel_time = std::accumulate(
-            edges.begin(),
-            edges.end(),
-            0.0f,
-            [this] (float acc, const BoostEdge& edge) -> float {
-                return acc + graph->g[edge].travel_time;
+            travel_time = 0.0f;
+
+            for(auto i = 0u; i < vertices.size(); ++i) {
+                travel_time += graph->exact_travel_time(vertices[i], vertices[(i + 1) % vertices.size()]);
             }
-            );
         }
     }
 
@@ -198,18 +245,14 @@ namespace op {
             vertices.begin(),
             vertices.end(),
             0.0f,
-            [this] (float acc, const BoostVertex& vertex) -> float {
-                return acc + graph->g[vertex].prize;
+            [this] (float acc, VertexIndex vertex) -> float {
+                return acc + graph->prize(vertex);
             }
         );
     }
 
-    bool Tour::visits_vertex(const BoostVertex& v) const {
-        return as::containers::contains(vertices, v);
-    }
-
     bool Tour::is_travel_time_correct() {
-        if(edges.size() == 0u) {
+        if(vertices.size() <= 1u) {
             return travel_time == 0.0f;
         }
 
@@ -221,6 +264,8 @@ namespace op {
     }
 
     bool Tour::are_edges_correct() const {
+        const auto edges = this->edges();
+
         if(edges.empty()) {
             return vertices.size() == 1u && vertices[0] == 0u;
         }
@@ -259,15 +304,14 @@ namespace op {
         return out;
     }
 
-    void Tour::do_2opt() {
+    TourEdgeList Tour::do_2opt() {
         assert(is_simple());
         assert(is_travel_time_correct());
-        assert(are_edges_correct());
-        assert(boost::source(edges.front(), graph->g) == 0u);
-        assert(boost::target(edges.back(), graph->g) == 0u);
+        assert(vertices.front() == 0u);
 
-        if(edges.size() < 4u) { return; }
+        if(vertices.size() < 4u) { return {}; }
 
+        TourEdgeList new_edges;
         float best_gain = 0.0f;
 
         do {
@@ -292,7 +336,17 @@ namespace op {
             }
 
             if(best_gain > 0.0f) {
-                std::vector<BoostVertex> new_vertices;
+                // The gain might have been computed with approximate travel times.
+                const auto best_next_j = (best_j + 1) % vertices.size();
+                const auto exact_gain = graph->exact_travel_time(vertices[best_i], vertices[best_i + 1]) +
+                                        graph->exact_travel_time(vertices[best_j], vertices[best_next_j]) -
+                                        graph->exact_travel_time(vertices[best_i], vertices[best_j]) -
+                                        graph->exact_travel_time(vertices[best_i + 1], vertices[best_next_j]);
+
+                new_edges.emplace_back(vertices[best_i], vertices[best_j]);
+                new_edges.emplace_back(vertices[best_i + 1], vertices[best_next_j]);
+
+                SmallVertexList new_vertices;
                 new_vertices.reserve(vertices.size());
 
                 for(auto k = 0u; k <= best_i; ++k) {
@@ -306,163 +360,416 @@ namespace op {
                 }
 
                 vertices = new_vertices;
-                travel_time -= best_gain;
+                update_positions(best_i + 1u, best_j + 1u);
+                update_prefix_travel_times(best_i + 1u, best_j + 1u);
+                shift_prefix_travel_times(best_j + 1u, -exact_gain);
+                travel_time -= exact_gain;
             }
         } while(best_gain > 0.0f);
 
-        calculate_edges_from_vertices();
-
         assert(is_simple());
         assert(is_travel_time_correct());
-        assert(are_edges_correct());
-        assert(boost::source(edges.front(), graph->g) == 0u);
-        assert(boost::target(edges.back(), graph->g) == 0u);
+        assert(vertices.front() == 0u);
+
+        return new_edges;
     }
 
-    std::vector<BoostVertex> Tour::make_travel_time_feasible_optimal() {
+    TourEdgeList Tour::do_2opt_neighbours() {
         assert(is_simple());
         assert(is_travel_time_correct());
-        assert(are_edges_correct());
-        assert(boost::source(edges.front(), graph->g) == 0u);
-        assert(boost::target(edges.back(), graph->g) == 0u);
+        assert(vertices.front() == 0u);
 
-        JGraph jgraph;
+        const auto n = vertices.size();
 
-        for(auto i = 0u; i < vertices.size(); ++i) {
-            boost::add_vertex(JVertexProperty{i, vertices[i], graph->g[vertices[i]].prize}, jgraph);
-        }
-        boost::add_vertex(JVertexProperty{vertices.size(), vertices[0], graph->g[vertices[0]].prize}, jgraph);
+        if(n < 4u) { return {}; }
+
+        TourEdgeList new_edges;
+
+        const auto succ = [&] (BoostVertex v) -> BoostVertex { return vertices[(positions[v] + 1u) % n]; };
+        const auto pred = [&] (BoostVertex v) -> BoostVertex { return vertices[(positions[v] + n - 1u) % n]; };
+
+        // Vertices whose don't-look bit is off: they are in the stack
+        // of vertices to look at, iff their bit is set.
+        SmallVertexList to_look(vertices.begin(), vertices.end());
+        VertexBitmap active = visited;
 
-        std::size_t id = 0u;
-        for(auto i = 0u; i <= vertices.size(); ++i) {
-            for(auto j = i + 1; j <= vertices.size(); ++j) {
-                if(i == 0u && j == vertices.size()) { continue; }
-                boost::add_edge(i, j, JEdgeProperty{id++, graph->travel_time(jgraph[i].original_v, jgraph[j].original_v)}, jgraph);
+        const auto activate = [&] (BoostVertex v) -> void {
+            if(!((active[v / 64u] >> (v % 64u)) & 1u)) {
+                active[v / 64u] |= std::uint64_t{1u} << (v % 64u);
+                to_look.push_back(static_cast<VertexIndex>(v));
             }
-        }
+        };
 
-        jgraph[boost::graph_bundle] = graph->max_travel_time;
+        while(!to_look.empty()) {
+            const BoostVertex a = to_look.back();
+            to_look.pop_back();
+            active[a / 64u] &= ~(std::uint64_t{1u} << (a % 64u));
 
-        using JPath = std::vector<JEdge>;
+            // Try to replace edge (a, a_adj) with edge (a, c), where c is
+            // one of a's neighbours, and edge (c, c_adj) with (a_adj, c_adj).
+            // Both the edge to the successor and the one to the predecessor
+            // of a are tried.
+            for(auto forward : {true, false}) {
+                const auto a_adj = forward ? succ(a) : pred(a);
+                const auto a_edge_travel_time = graph->travel_time(a, a_adj);
+                bool improved = false;
 
-        std::vector<JPath> opt_paths;
-        std::vector<JLabel> opt_labels;
-        JVFunctor jvf{jgraph};
-        JEFunctor jef{jgraph};
+                for(const auto& neighbour : graph->proximity_map[a]) {
+                    // Neighbours are sorted by travel time: from here on,
+                    // the new edge (a, c) is not shorter than (a, a_adj).
+                    if(neighbour.travel_time >= a_edge_travel_time) { break; }
 
-        boost::r_c_shortest_paths(
-            jgraph,
-            make_property_map<JVertex>(jvf),
-            make_property_map<JEdge>(jef),
-            0u,
-            vertices.size(),
-            opt_paths,
-            opt_labels,
-            JLabel{graph->g[0u].prize, 0},
-            JLabelExtender{},
-            [] (const JLabel& l1, const JLabel& l2) { return l1 < l2; }
-        );
+                    const BoostVertex c = neighbour.vertex;
+
+                    if(c == a_adj || !visits_vertex(c)) { continue; }
+
+                    const auto c_adj = forward ? succ(c) : pred(c);
+
+                    if(c_adj == a) { continue; }
+
+                    const auto gain = a_edge_travel_time +
+                                      graph->travel_time(c, c_adj) -
+                                      neighbour.travel_time -
+                                      graph->travel_time(a_adj, c_adj);
+
+                    if(gain <= 1) { continue; }
 
-        assert(!opt_paths.empty());
+                    // The move is the classical 2-opt move (i, j), which
+                    // replaces edges (i, i + 1) and (j, j + 1) and reverses
+                    // the vertices in positions i + 1, ..., j.
+                    auto i = forward ? positions[a] : positions[a_adj];
+                    auto j = forward ? positions[c] : positions[c_adj];
 
-        std::vector<std::size_t> ids(opt_paths.size());
-        std::iota(ids.begin(), ids.end(), 0u);
-        std::sort(ids.begin(), ids.end(), [&] (const auto& i1, const auto& i2) { return opt_labels[i1].prize < opt_labels[i2].prize; });
+                    if(i > j) { std::swap(i, j); }
 
-        const auto& opt = opt_paths[ids.back()];
+                    // The gain might have been computed with approximate travel times.
+                    const auto next_j = (j + 1u) % n;
+                    const auto exact_gain = graph->exact_travel_time(vertices[i], vertices[i + 1u]) +
+                                            graph->exact_travel_time(vertices[j], vertices[next_j]) -
+                                            graph->exact_travel_time(vertices[i], vertices[j]) -
+                                            graph->exact_travel_time(vertices[i + 1u], vertices[next_j]);
 
-        std::vector<BoostVertex> opt_vertices;
-        for(const auto& e : opt) {
-            opt_vertices.push_back(jgraph[boost::source(e, jgraph)].original_v);
+                    if(exact_gain <= 0.0f) { continue; }
+
+                    std::reverse(vertices.begin() + i + 1u, vertices.begin() + j + 1u);
+                    update_positions(i + 1u, j + 1u);
+                    travel_time -= exact_gain;
+
+                    new_edges.emplace_back(a, c);
+                    new_edges.emplace_back(a_adj, c_adj);
+
+                    activate(a);
+                    activate(a_adj);
+                    activate(c);
+                    activate(c_adj);
+
+                    improved = true;
+                    break;
+                }
+
+                if(improved) { break; }
+            }
         }
 
-        std::vector<BoostVertex> rem_vertices;
-        for(const auto& v : vertices) {
-            if(!as::containers::contains(opt_vertices, v)) {
-                assert(v != 0u);
-                rem_vertices.push_back(v);
+        // Reversals change the order of the legs: the prefix sums are
+        // rebuilt once, at the end.
+        update_prefix_travel_times(1u, n);
+
+        assert(is_simple());
+        assert(is_travel_time_correct());
+        assert(vertices.front() == 0u);
+
+        return new_edges;
+    }
+
+    TourEdgeList Tour::do_or_opt(std::size_t max_chain_length) {
+        assert(is_simple());
+        assert(is_travel_time_correct());
+        assert(vertices.front() == 0u);
+
+        const auto n = vertices.size();
+
+        if(n < 4u) { return {}; }
+
+        TourEdgeList new_edges;
+
+        const auto succ = [&] (BoostVertex v) -> BoostVertex { return vertices[(positions[v] + 1u) % n]; };
+        const auto pred = [&] (BoostVertex v) -> BoostVertex { return vertices[(positions[v] + n - 1u) % n]; };
+
+        // Chain currently being moved, between positions first and last.
+        std::size_t first = 0u, last = 0u;
+
+        const auto in_chain = [&] (BoostVertex v) -> bool {
+            return positions[v] >= first && positions[v] <= last;
+        };
+
+        // Moves the chain between vertices u and w = succ(u), and reverses it
+        // if required. Returns false, without changing the tour, if the move
+        // does not shorten it.
+        const auto try_move = [&] (BoostVertex u, BoostVertex w, bool reversed) -> bool {
+            if(in_chain(u) || in_chain(w)) { return false; }
+
+            const auto p = vertices[first - 1u];
+            const auto q = vertices[(last + 1u) % n];
+            const auto c_first = vertices[first];
+            const auto c_last = vertices[last];
+            const auto c_to_u = reversed ? c_last : c_first;
+            const auto c_to_w = reversed ? c_first : c_last;
+
+            const auto gain = graph->travel_time(p, c_first) +
+                              graph->travel_time(c_last, q) -
+                              graph->travel_time(p, q) -
+                              graph->travel_time(u, c_to_u) -
+                              graph->travel_time(c_to_w, w) +
+                              graph->travel_time(u, w);
+
+            if(gain <= 1) { return false; }
+
+            // The gain might have been computed with approximate travel times.
+            const auto exact_gain = graph->exact_travel_time(p, c_first) +
+                                    graph->exact_travel_time(c_last, q) -
+                                    graph->exact_travel_time(p, q) -
+                                    graph->exact_travel_time(u, c_to_u) -
+                                    graph->exact_travel_time(c_to_w, w) +
+                                    graph->exact_travel_time(u, w);
+
+            if(exact_gain <= 0.0f) { return false; }
+
+            const auto u_pos = positions[u];
+            const auto chain_length = last - first + 1u;
+            std::size_t new_first, update_first, update_last;
+
+            if(u_pos > last) {
+                // Move the chain forward, just after u.
+                std::rotate(vertices.begin() + first, vertices.begin() + last + 1u, vertices.begin() + u_pos + 1u);
+                new_first = u_pos + 1u - chain_length;
+                update_first = first;
+                update_last = u_pos + 1u;
+            } else {
+                // Move the chain backward, just after u.
+                std::rotate(vertices.begin() + u_pos + 1u, vertices.begin() + first, vertices.begin() + last + 1u);
+                new_first = u_pos + 1u;
+                update_first = u_pos + 1u;
+                update_last = last + 1u;
+            }
+
+            if(reversed) {
+                std::reverse(vertices.begin() + new_first, vertices.begin() + new_first + chain_length);
+            }
+
+            update_positions(update_first, update_last);
+            travel_time -= exact_gain;
+
+            new_edges.emplace_back(p, q);
+            new_edges.emplace_back(u, c_to_u);
+            new_edges.emplace_back(c_to_w, w);
+
+            return true;
+        };
+
+        bool improved = true;
+
+        while(improved) {
+            improved = false;
+
+            for(first = 1u; first < n; ++first) {
+                for(auto length = 1u; length <= max_chain_length && first + length <= n; ++length) {
+                    last = first + length - 1u;
+
+                    const auto c_first = vertices[first];
+                    const auto c_last = vertices[last];
+                    const auto removal_gain = graph->travel_time(vertices[first - 1u], c_first) +
+                                              graph->travel_time(c_last, vertices[(last + 1u) % n]) -
+                                              graph->travel_time(vertices[first - 1u], vertices[(last + 1u) % n]);
+
+                    bool moved = false;
+
+                    // Neighbours are sorted by travel time: from here on, the edge
+                    // connecting the chain to the neighbour costs more than what
+                    // removing the chain saves.
+                    for(const auto& neighbour : graph->proximity_map[c_first]) {
+                        if(neighbour.travel_time >= removal_gain) { break; }
+                        if(!visits_vertex(neighbour.vertex)) { continue; }
+
+                        const BoostVertex x = neighbour.vertex;
+
+                        if(try_move(x, succ(x), false) || try_move(pred(x), x, true)) {
+                            moved = true;
+                            break;
+                        }
+                    }
+
+                    if(!moved) {
+                        for(const auto& neighbour : graph->proximity_map[c_last]) {
+                            if(neighbour.travel_time >= removal_gain) { break; }
+                            if(!visits_vertex(neighbour.vertex)) { continue; }
+
+                            const BoostVertex y = neighbour.vertex;
+
+                            if(try_move(y, succ(y), true) || try_move(pred(y), y, false)) {
+                                moved = true;
+                                break;
+                            }
+                        }
+                    }
+
+                    if(moved) {
+                        improved = true;
+                        break;
+                    }
+                }
             }
         }
 
-        for(const auto& v : rem_vertices) {
-            remove_vertex(v);
+        // Moves change the order of the legs: the prefix sums are
+        // rebuilt once, at the end.
+        update_prefix_travel_times(1u, n);
+
+        assert(is_simple());
+        assert(is_travel_time_correct());
+        assert(vertices.front() == 0u);
+
+        return new_edges;
+    }
+
+    SmallVertexList Tour::make_travel_time_feasible_optimal(TourEdgeList* new_edges) {
+        assert(is_simple());
+        assert(is_travel_time_correct());
+        assert(vertices.front() == 0u);
+
+        if(travel_time <= graph->max_travel_time) { return {}; }
+
+        // The heuristic solution gives the labelling a bound to start from.
+        Tour heuristic_tour = *this;
+        TourEdgeList heuristic_new_edges;
+        auto removed_vertices = heuristic_tour.make_travel_time_feasible_naive(&heuristic_new_edges);
+
+        TourRemovalLabelling labelling{*graph, vertices};
+
+        if(auto optimal_removed_vertices = labelling.vertices_to_remove(heuristic_tour.total_prize)) {
+            removed_vertices = std::move(*optimal_removed_vertices);
+            heuristic_new_edges = remove_vertices(removed_vertices.data(), removed_vertices.size());
+        } else {
+            *this = std::move(heuristic_tour);
+        }
+
+        if(new_edges) {
+            new_edges->insert(new_edges->end(), heuristic_new_edges.begin(), heuristic_new_edges.end());
         }
 
         assert(is_simple());
         assert(is_travel_time_correct());
-        assert(are_edges_correct());
-        assert(boost::source(edges.front(), graph->g) == 0u);
-        assert(boost::target(edges.back(), graph->g) == 0u);
+        assert(vertices.front() == 0u);
 
-        return rem_vertices;
+        return removed_vertices;
     }
 
-    std::vector<BoostVertex> Tour::make_travel_time_feasible_naive() {
+    SmallVertexList Tour::make_travel_time_feasible_naive(TourEdgeList* new_edges) {
         assert(is_travel_time_correct());
-        assert(are_edges_correct());
-        assert(boost::source(edges.front(), graph->g) == 0u);
-        assert(boost::target(edges.back(), graph->g) == 0u);
+        assert(vertices.front() == 0u);
 
         if(travel_time <= graph->max_travel_time) { return {}; }
 
-        std::vector<BoostVertex> removed_vertices;
-        std::vector<VertexRemovalPrice> removals(vertices.size());
+        // Removals are chosen on a linked list over the positions of the vertices, and
+        // applied to the tour in a single pass at the end. Removing a vertex only changes
+        // the removal price of the vertices before and after it, so the removal with the
+        // best score comes from a mutable heap, where only those two prices are updated.
+        const auto n = vertices.size();
+        std::vector<std::size_t> prev(n), next(n);
 
-        removals[0u] = VertexRemovalPrice(); // Depot
-        for(auto i = 1u; i < vertices.size(); ++i) {
-            removals[i] = price_vertex_removal(i);
+        for(auto i = 0u; i < n; ++i) {
+            prev[i] = (i + n - 1u) % n;
+            next[i] = (i + 1u) % n;
         }
 
-        while(travel_time > graph->max_travel_time) {
-            std::size_t best_removal_pos = 1u;
-            VertexRemovalPrice best_removal = removals[1u];
+        const auto price_removal = [&] (std::size_t position) -> VertexRemovalPrice {
+            const auto vertex_before = vertices[prev[position]];
+            const auto vertex = vertices[position];
+            const auto vertex_after = vertices[next[position]];
 
-            for(auto i = 2u; i < removals.size(); ++i) {
-                if(removals[i].score > best_removal.score) {
-                    best_removal_pos = i;
-                    best_removal = removals[i];
-                }
-            }
+            const auto decrease_in_travel_time = graph->travel_time(vertex_before, vertex) +
+                                                 graph->travel_time(vertex, vertex_after) -
+                                                 graph->travel_time(vertex_before, vertex_after);
 
-            removed_vertices.push_back(best_removal.vertex);
-            remove_vertex_by_position(best_removal_pos);
-            removals.erase(removals.begin() + best_removal_pos);
+            const auto decrease_in_prize = graph->prize(vertex);
 
-            assert(removals.size() == vertices.size());
+            return {vertex, decrease_in_travel_time, decrease_in_prize, decrease_in_travel_time / decrease_in_prize};
+        };
 
-            if(best_removal_pos > 1u) {
-                removals[best_removal_pos - 1u] = price_vertex_removal(best_removal_pos - 1u);
-            }
+        struct HeapEntry {
+            float score;
+            std::size_t position;
 
-            if(best_removal_pos < removals.size()) {
-                removals[best_removal_pos] = price_vertex_removal(best_removal_pos);
+            // Best score on top; ties go to the vertex coming first in the tour.
+            bool operator<(const HeapEntry& other) const {
+                return score < other.score || (score == other.score && position > other.position);
             }
+        };
+
+        using Heap = boost::heap::d_ary_heap<HeapEntry, boost::heap::arity<4>, boost::heap::mutable_<true>>;
+
+        Heap heap;
+        std::vector<Heap::handle_type> handles(n);
+
+        for(auto i = 1u; i < n; ++i) {
+            handles[i] = heap.push({price_removal(i).score, i});
+        }
+
+        SmallVertexList removed_vertices;
+        float new_travel_time = travel_time;
+
+        while(new_travel_time > graph->max_travel_time) {
+            assert(!heap.empty());
+
+            const auto position = heap.top().position;
+            const auto before = prev[position], after = next[position];
+
+            heap.pop();
+
+            new_travel_time -= graph->exact_travel_time(vertices[before], vertices[position]) +
+                               graph->exact_travel_time(vertices[position], vertices[after]) -
+                               graph->exact_travel_time(vertices[before], vertices[after]);
+
+            removed_vertices.push_back(vertices[position]);
+            next[before] = after;
+            prev[after] = before;
+
+            if(before != 0u) { heap.update(handles[before], {price_removal(before).score, before}); }
+            if(after != 0u) { heap.update(handles[after], {price_removal(after).score, after}); }
+        }
+
+        const auto bridging_edges = remove_vertices(removed_vertices.data(), removed_vertices.size());
+
+        if(new_edges) {
+            new_edges->insert(new_edges->end(), bridging_edges.begin(), bridging_edges.end());
+        }
+
+        if(travel_time > graph->max_travel_time) {
+            // The travel time recomputed by remove_vertices() can differ by rounding errors.
+            const auto more_removed_vertices = make_travel_time_feasible_naive(new_edges);
+            removed_vertices.insert(removed_vertices.end(), more_removed_vertices.begin(), more_removed_vertices.end());
         }
 
         assert(is_travel_time_correct());
-        assert(are_edges_correct());
-        assert(boost::source(edges.front(), graph->g) == 0u);
-        assert(boost::target(edges.back(), graph->g) == 0u);
+        assert(vertices.front() == 0u);
 
         return removed_vertices;
     }
 
-    bool Tour::remove_vertex(std::vector<BoostVertex>::iterator vertex_it) {
+    bool Tour::remove_vertex(SmallVertexList::iterator vertex_it) {
         using as::console::warning;
 
         assert(vertex_it != vertices.begin()); // The depot.
         assert(vertex_it != vertices.end());
         assert(is_travel_time_correct());
-        assert(are_edges_correct());
-        assert(boost::source(edges.front(), graph->g) == 0u);
-        assert(boost::target(edges.back(), graph->g) == 0u);
+        assert(vertices.front() == 0u);
 
         if(vertices.size() == 1u) {
             return false;
         }
 
         if(vertices.size() == 2u) {
-            *this = Tour(graph.get(), std::vector<BoostVertex>{0u});
+            *this = Tour(graph.get(), SmallVertexList{0u});
             return true;
         }
 
@@ -470,58 +777,39 @@ namespace op {
         auto vertex_pos = vertex_it - vertices.begin();
 
         assert(!graph->g[vertex].depot);
-        assert(graph->g[vertex].reachable);
+        assert(graph->is_reachable(vertex));
 
         const auto vertex_it_before = vertex_it - 1;
         auto vertex_it_after = vertex_it + 1;
 
         if(vertex_it_after == vertices.end()) { vertex_it_after = vertices.begin(); }
 
-        auto new_edge = boost::edge(*vertex_it_before, *vertex_it_after, graph->g).first;
-
-        const auto old_edge_pred_pos = vertex_pos - 1;
-        const auto old_edge_succ_pos = vertex_pos;
-
-        assert(old_edge_pred_pos >= 0);
-        assert(static_cast<std::size_t>(old_edge_pred_pos) < edges.size() - 1u);
-        assert(old_edge_succ_pos > 0);
-        assert(static_cast<std::size_t>(old_edge_succ_pos) < edges.size());
-
-        assert(boost::edge(*vertex_it_before, vertex, graph->g).first == edges[old_edge_pred_pos]);
-        assert(boost::edge(vertex, *vertex_it_after, graph->g).first == edges[old_edge_succ_pos]);
-
         const auto travel_time_diff =
-            graph->g[edges[old_edge_pred_pos]].travel_time +
-            graph->g[edges[old_edge_succ_pos]].travel_time -
-            graph->g[new_edge].travel_time;
+            graph->exact_travel_time(*vertex_it_before, vertex) +
+            graph->exact_travel_time(vertex, *vertex_it_after) -
+            graph->exact_travel_time(*vertex_it_before, *vertex_it_after);
 
-        edges[old_edge_pred_pos] = new_edge;
-        edges.erase(edges.begin() + old_edge_succ_pos);
         vertices.erase(vertex_it);
+        visited[vertex / 64u] &= ~(std::uint64_t{1u} << (vertex % 64u));
+        update_positions(static_cast<std::size_t>(vertex_pos), vertices.size());
+        prefix_travel_times.erase(prefix_travel_times.begin() + vertex_pos);
+        shift_prefix_travel_times(static_cast<std::size_t>(vertex_pos), -travel_time_diff);
         travel_time -= travel_time_diff;
-        total_prize -= graph->g[vertex].prize;
+        total_prize -= graph->prize(vertex);
 
-        assert(boost::source(edges.front(), graph->g) == 0u);
-        assert(boost::target(edges.back(), graph->g) == 0u);
+        assert(vertices.front() == 0u);
         assert(is_travel_time_correct());
-        assert(are_edges_correct());
 
         return true;
     }
 
     bool Tour::remove_vertex(const BoostVertex& vertex) {
-        auto vertex_it = std::find(vertices.begin(), vertices.end(), vertex);
-
-        assert(vertex_it != vertices.end());
-
-        return remove_vertex(vertex_it);
+        return remove_vertex(vertices.begin() + static_cast<std::ptrdiff_t>(position_of(vertex)));
     }
 
     bool Tour::remove_vertex_if_present(const BoostVertex& vertex) {
-        auto vertex_it = std::find(vertices.begin(), vertices.end(), vertex);
-
-        if(vertex_it != vertices.end()) {
-            return remove_vertex(vertex_it);
+        if(visits_vertex(vertex)) {
+            return remove_vertex(vertex);
         } else {
             return false;
         }
@@ -534,64 +822,152 @@ namespace op {
         return remove_vertex(vertices.begin() + position);
     }
 
-    void Tour::add_vertex(const BoostVertex& vertex, std::size_t position) {
-        using namespace as::containers;
+    TourEdgeList Tour::remove_segment(std::size_t first, std::size_t last) {
+        assert(first > 0u); // No depot!
+        assert(first <= last);
+        assert(last <= vertices.size());
+        assert(is_travel_time_correct());
+        assert(vertices.front() == 0u);
+
+        if(first == last) { return {}; }
+
+        if(last - first + 1u == vertices.size()) {
+            // Only the depot is left: the tour is the loop on the depot.
+            *this = Tour(graph.get(), SmallVertexList{0u});
+            return {{0u, 0u}};
+        }
 
+        const auto vertex_before = vertices[first - 1u];
+        const auto vertex_after = vertices[last % vertices.size()];
+
+        // Travel time from vertex_before to vertex_after, through the segment.
+        const auto segment_travel_time = travel_time_between(first - 1u, last - 1u) +
+                                         graph->exact_travel_time(vertices[last - 1u], vertex_after);
+        const auto travel_time_diff = segment_travel_time - graph->exact_travel_time(vertex_before, vertex_after);
+
+        for(auto i = first; i < last; ++i) {
+            const auto vertex = vertices[i];
+
+            assert(!graph->g[vertex].depot);
+
+            visited[vertex / 64u] &= ~(std::uint64_t{1u} << (vertex % 64u));
+            total_prize -= graph->prize(vertex);
+        }
+
+        vertices.erase(vertices.begin() + first, vertices.begin() + last);
+        prefix_travel_times.erase(prefix_travel_times.begin() + first, prefix_travel_times.begin() + last);
+        update_positions(first, vertices.size());
+        shift_prefix_travel_times(first, -travel_time_diff);
+        travel_time -= travel_time_diff;
+
+        assert(vertices.front() == 0u);
         assert(is_travel_time_correct());
-        assert(are_edges_correct());
-        assert(position < vertices.size());
-        assert(!contains(vertices, vertex));
-        assert(!graph->g[vertex].depot);
-        assert(graph->g[vertex].reachable);
-        
-        assert(edges.empty() || boost::source(edges.front(), graph->g) == 0u);
-        assert(edges.empty() || boost::target(edges.back(), graph->g) == 0u);
 
-        if(vertices.size() == 1u) {
-            assert(vertices[0] == 0u); // Only contains the depot
-            vertices.push_back(vertex);
+        return {{vertex_before, vertex_after}};
+    }
 
-            assert(edges.size() == 0u);
+    TourEdgeList Tour::remove_vertices(const VertexIndex* to_remove, std::size_t n) {
+        assert(is_travel_time_correct());
+        assert(vertices.front() == 0u);
+        assert(n < vertices.size());
 
-            const auto one_way = boost::edge(0u, vertex, graph->g);
-            const auto other_way = boost::edge(vertex, 0u, graph->g);
+        if(n == 0u) { return {}; }
 
-            assert(one_way.second);
-            assert(other_way.second);
+        if(n + 1u == vertices.size()) {
+            // Only the depot is left: the tour is the loop on the depot.
+            *this = Tour(graph.get(), SmallVertexList{0u});
+            return {{0u, 0u}};
+        }
 
-            edges.push_back(one_way.first);
-            edges.push_back(other_way.first);
+        for(auto i = 0u; i < n; ++i) {
+            const auto vertex = to_remove[i];
 
-            travel_time = graph->g[one_way.first].travel_time;
-            travel_time += graph->g[other_way.first].travel_time;
+            assert(vertex != 0u);
+            assert(visits_vertex(vertex));
 
-            total_prize = graph->g[vertex].prize;
+            visited[vertex / 64u] &= ~(std::uint64_t{1u} << (vertex % 64u));
+            total_prize -= graph->prize(vertex);
+        }
 
-            assert(is_travel_time_correct());
-        } else {
-            const auto vertex_before = vertices[position];
-            const auto vertex_after = vertices[(position + 1u) % vertices.size()];
+        // Decrease in travel time for the runs of removed vertices
+        // found so far, which also shifts the following prefix sums.
+        float travel_time_diff = 0.0f;
+
+        // Edges joining the vertices around each run of removed vertices.
+        TourEdgeList bridging_edges;
+
+        // Last vertex kept, with its position and prefix sum before compacting.
+        VertexIndex last_kept = 0u;
+        std::size_t last_kept_position = 0u;
+        float last_kept_prefix = 0.0f;
+
+        std::size_t new_position = 1u;
 
-            const auto remove_edge = boost::edge(vertex_before, vertex_after, graph->g).first;
-            auto remove_edge_it = std::find(edges.begin(), edges.end(), remove_edge);
-
-            // In the case the tour is a loop, we would have:
-            // (0, v) -- (v, 0)
-            // The edge we want to remove is (v, 0) when we
-            // insert the new vertex in position 1, i.e. after
-            // v. However, since edges are not oriented, we are
-            // finding (0, v). So, we need to manually increment
-            // this iterator to point to the correct back-edge.
-            if(edges.size() == 2u && position == 1u) {
-                ++remove_edge_it;
+        for(auto position = 1u; position < vertices.size(); ++position) {
+            const auto vertex = vertices[position];
+
+            if(!visits_vertex(vertex)) { continue; }
+
+            if(position != last_kept_position + 1u) {
+                // The vertices between last_kept and vertex were removed.
+                travel_time_diff += prefix_travel_times[position] - last_kept_prefix -
+                                    graph->exact_travel_time(last_kept, vertex);
+                bridging_edges.emplace_back(last_kept, vertex);
             }
 
-            assert(remove_edge_it != edges.end());
+            last_kept = vertex;
+            last_kept_position = position;
+            last_kept_prefix = prefix_travel_times[position];
+
+            vertices[new_position] = vertex;
+            positions[vertex] = static_cast<VertexIndex>(new_position);
+            prefix_travel_times[new_position] = last_kept_prefix - travel_time_diff;
+            ++new_position;
+        }
+
+        if(last_kept_position + 1u != vertices.size()) {
+            // The vertices between last_kept and the depot were removed.
+            const auto last_vertex = vertices.back();
+
+            travel_time_diff += prefix_travel_times.back() - last_kept_prefix +
+                                graph->exact_travel_time(last_vertex, 0u) -
+                                graph->exact_travel_time(last_kept, 0u);
+            bridging_edges.emplace_back(last_kept, 0u);
+        }
+
+        vertices.resize(new_position);
+        prefix_travel_times.resize(new_position);
+        travel_time -= travel_time_diff;
+
+        assert(vertices.front() == 0u);
+        assert(is_travel_time_correct());
+
+        return bridging_edges;
+    }
+
+    void Tour::add_vertex(const BoostVertex& vertex, std::size_t position) {
+        assert(is_travel_time_correct());
+        assert(position < vertices.size());
+        assert(!visits_vertex(vertex));
+        assert(!graph->g[vertex].depot);
+        assert(graph->is_reachable(vertex));
+        assert(vertices.front() == 0u);
 
-            const auto ne1 = boost::edge(vertex_before, vertex, graph->g);
-            const auto ne2 = boost::edge(vertex, vertex_after, graph->g);
+        if(vertices.size() == 1u) {
+            assert(vertices[0] == 0u); // Only contains the depot
+            vertices.push_back(vertex);
+            visited[vertex / 64u] |= std::uint64_t{1u} << (vertex % 64u);
+            positions[vertex] = 1u;
+            prefix_travel_times.push_back(graph->exact_travel_time(0u, vertex));
 
-            assert(ne1.second && ne2.second);
+            travel_time = 2 * graph->exact_travel_time(0u, vertex);
+
+            total_prize = graph->prize(vertex);
+
+            assert(is_travel_time_correct());
+        } else {
+            const auto vertex_before = vertices[position];
+            const auto vertex_after = vertices[(position + 1u) % vertices.size()];
 
             // Insert the new vertex:
             // (We use position as the index of the vertex after which
@@ -599,31 +975,58 @@ namespace op {
             // hand, wants an iterator to the item before which the new
             // item is inserted. Hence, we add 1 to position.)
             vertices.insert(vertices.begin() + position + 1, vertex);
-
-            // If we are removing the first edge, make sure the one we are
-            // replacing it with starts at the depot!
-            assert(remove_edge_it != edges.begin() || vertex_before == 0u);
-
-            // Subsitute the the old edge with the first of the two new edges:
-            *remove_edge_it = ne1.first;
-
-            // Add the second of the two new edges:
-            edges.insert(remove_edge_it + 1, ne2.first);
+            visited[vertex / 64u] |= std::uint64_t{1u} << (vertex % 64u);
+            update_positions(position + 1u, vertices.size());
+
+            const auto travel_time_to_vertex = graph->exact_travel_time(vertex_before, vertex);
+            const auto travel_time_diff = travel_time_to_vertex +
+                                          graph->exact_travel_time(vertex, vertex_after) -
+                                          graph->exact_travel_time(vertex_before, vertex_after);
+
+            // Update prefix sums: the vertices after the new one are
+            // reached later, by the increase in travel time.
+            prefix_travel_times.insert(
+                prefix_travel_times.begin() + position + 1,
+                prefix_travel_times[position] + travel_time_to_vertex
+            );
+            shift_prefix_travel_times(position + 2u, travel_time_diff);
 
             // Update travel time:
-            travel_time -= graph->g[remove_edge].travel_time;
-            travel_time += graph->g[ne1.first].travel_time;
-            travel_time += graph->g[ne2.first].travel_time;
+            travel_time += travel_time_diff;
 
             // Update prize:
-            total_prize += graph->g[vertex].prize;
+            total_prize += graph->prize(vertex);
         }
 
-        assert(!edges.empty());
-        assert(boost::source(edges.front(), graph->g) == 0u);
-        assert(boost::target(edges.back(), graph->g) == 0u);
+        assert(vertices.front() == 0u);
         assert(is_travel_time_correct());
-        assert(are_edges_correct());
+    }
+
+    bool Tour::is_insertion_feasible(const VertexInsertionPrice& insertion) const {
+        const auto vertex_before = this->vertex_before(insertion);
+        const auto vertex_after = this->vertex_after(insertion);
+
+        if(graph->has_pruned_edges()) {
+            // Pruned edges cannot be part of any feasible tour.
+            if(!graph->has_edge(vertex_before, insertion.vertex) || !graph->has_edge(insertion.vertex, vertex_after)) {
+                return false;
+            }
+        }
+
+        const auto new_travel_time = travel_time + insertion.increase_in_travel_time;
+
+        // The increase is made of three travel times, each of which can be approximate.
+        const auto tolerance = 3.0f * graph->distances.max_error();
+
+        if(new_travel_time + tolerance <= graph->max_travel_time) { return true; }
+        if(new_travel_time - tolerance > graph->max_travel_time) { return false; }
+
+        // Close to the boundary: recompute the increase exactly.
+        const auto exact_increase = graph->exact_travel_time(vertex_before, insertion.vertex) +
+                                    graph->exact_travel_time(insertion.vertex, vertex_after) -
+                                    graph->exact_travel_time(vertex_before, vertex_after);
+
+        return travel_time + exact_increase <= graph->max_travel_time;
     }
 
     VertexRemovalPrice Tour::price_vertex_removal(std::size_t position) const {
@@ -638,16 +1041,14 @@ namespace op {
                                              graph->travel_time(vertex, vertex_after) -
                                              graph->travel_time(vertex_before, vertex_after);
 
-        const auto decrease_in_prize = graph->g[vertex].prize;
+        const auto decrease_in_prize = graph->prize(vertex);
 
         return {vertex, decrease_in_travel_time, decrease_in_prize, decrease_in_travel_time / decrease_in_prize};
     }
 
     VertexInsertionPrice Tour::price_vertex_insertion(const BoostVertex& vertex, std::size_t position) const {
-        using namespace as::containers;
-
         assert(position < vertices.size());
-        assert(!contains(vertices, vertex));
+        assert(!visits_vertex(vertex));
 
         const auto vertex_before = vertices[position];
         const auto vertex_after = vertices[(position + 1u) % vertices.size()];
@@ -656,9 +1057,30 @@ namespace op {
                                              graph->travel_time(vertex, vertex_after) -
                                              graph->travel_time(vertex_before, vertex_after);
 
-        const auto increase_in_prize = graph->g[vertex].prize;
+        const auto increase_in_prize = graph->prize(vertex);
+
+        return {static_cast<VertexIndex>(vertex), position, increase_in_travel_time, increase_in_prize, increase_in_travel_time / increase_in_prize};
+    }
 
-        return {vertex, position, increase_in_travel_time, increase_in_prize, increase_in_travel_time / increase_in_prize};
+    void Tour::price_vertex_insertions(const BoostVertex& vertex, std::vector<VertexInsertionPrice>& insertions) const {
+        assert(!vertices.empty());
+        assert(!visits_vertex(vertex));
+
+        std::vector<float> travel_times(vertices.size());
+        graph->travel_times_from(vertex, vertices.data(), vertices.size(), travel_times.data());
+
+        const auto increase_in_prize = graph->prize(vertex);
+
+        insertions.reserve(insertions.size() + vertices.size());
+
+        for(auto position = 0u; position < vertices.size(); ++position) {
+            const auto next = (position + 1u) % vertices.size();
+            const auto increase_in_travel_time = travel_times[position] +
+                                                 travel_times[next] -
+                                                 graph->travel_time(vertices[position], vertices[next]);
+
+            insertions.push_back({static_cast<VertexIndex>(vertex), position, increase_in_travel_time, increase_in_prize, increase_in_travel_time / increase_in_prize});
+        }
     }
 
     bool Tour::is_simple() const {
@@ -701,7 +1123,7 @@ namespace op {
 
         for(const auto& vertex : vertices) {
             ptree vertex_t;
-            vertex_t.put("", vertex);
+            vertex_t.put("", graph->original_id(vertex));
             vertices_ary.push_back(std::make_pair("", vertex_t));
         }
 
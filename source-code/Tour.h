@@ -7,6 +7,10 @@
 
 #include <experimental/filesystem>
 #include <experimental/memory>
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
 #include "GraphTypes.h"
 
 namespace op {
@@ -14,15 +18,25 @@ namespace op {
     class Graph;
 
     struct VertexInsertionPrice {
-        BoostVertex vertex;
+        VertexIndex vertex;
         std::size_t position;
         float increase_in_travel_time;
         float increase_in_prize;
         float score;
     };
 
+    /**
+     * List of travel times, with the same inline storage as SmallVertexList.
+     */
+    using TravelTimeList = boost::container::small_vector<float, small_list_capacity>;
+
+    /**
+     * Edges of a tour, given by their endpoints. Edges are undirected: (v, w) and (w, v) are the same edge.
+     */
+    using TourEdgeList = std::vector<std::pair<VertexIndex, VertexIndex>>;
+
     struct VertexRemovalPrice {
-        BoostVertex vertex;
+        VertexIndex vertex;
         float decrease_in_travel_time;
         float decrease_in_prize;
         float score;
@@ -40,12 +54,27 @@ namespace op {
         /**
          * List of vertices composing the path.
          */
-        std::vector<BoostVertex> vertices;
+        SmallVertexList vertices;
 
         /**
-         * List of edges composing the path.
+         * Position of each vertex visited by the tour in the vertices
+         * list, indexed by vertex. Entries of vertices which are not
+         * visited are meaningless.
          */
-        std::vector<BoostEdge> edges;
+        SmallVertexList positions;
+
+        /**
+         * Bitmap of the vertices visited by the tour: vertex v is
+         * visited iff bit v % 64 of word v / 64 is set.
+         */
+        VertexBitmap visited;
+
+        /**
+         * Prefix sums of the (exact) travel times of the legs of the tour:
+         * entry i is the travel time along the tour from the depot to the
+         * vertex at position i. Entry 0 is, therefore, always zero.
+         */
+        TravelTimeList prefix_travel_times;
 
         /**
          * Total travel time along the tour.
@@ -68,7 +97,7 @@ namespace op {
          * @param graph The underlying graph.
          * @param edges The (ordered) edges of the tour.
          */
-        Tour(const Graph *const graph, std::vector<BoostEdge> edges);
+        Tour(const Graph *const graph, const std::vector<BoostEdge>& edges);
 
         /**
          * Construct by passing the graph and the vertex list.
@@ -76,7 +105,7 @@ namespace op {
          * @param graph     The underlying graph.
          * @param vertices  The (ordered) vertices of the tour.
          */
-        Tour(const Graph *const graph, std::vector<BoostVertex> vertices);
+        Tour(const Graph *const graph, SmallVertexList vertices);
 
         /**
          * Builds a path reading a solution file.
@@ -86,13 +115,71 @@ namespace op {
          */
         Tour(const Graph *const graph, std::experimental::filesystem::path solution_file);
 
+        /**
+         * Gives the edges of the tour, in order, starting from the depot.
+         * The tour only stores its vertices, so the edges are computed
+         * on each call: use it outside of hot paths, e.g. to export a
+         * solution. It needs a graph with materialised edges, and a tour
+         * which does not use pruned edges (see Graph::edge()).
+         *
+         * @return The edges of the tour (none if it only visits the depot).
+         */
+        std::vector<BoostEdge> edges() const;
+
         /**
          * Tells whether the tour visits a vertex.
          *
          * @param v The vertex.
          * @return  True iff the tour visits the vertex.
          */
-        bool visits_vertex(const BoostVertex& v) const;
+        bool visits_vertex(const BoostVertex& v) const {
+            return (visited[v / 64u] >> (v % 64u)) & 1u;
+        }
+
+        /**
+         * Gives the position of a vertex in the vertices list, in O(1)
+         * time. The vertex must be visited by the tour.
+         *
+         * @param v The vertex.
+         * @return  Its position.
+         */
+        std::size_t position_of(const BoostVertex& v) const {
+            assert(visits_vertex(v));
+            return positions[v];
+        }
+
+        /**
+         * Gives the travel time along the tour between the vertices at two
+         * positions, in O(1) time. Positions must be valid, and first
+         * cannot be greater than last.
+         *
+         * @param first     Position of the first vertex of the sub-path.
+         * @param last      Position of the last vertex of the sub-path.
+         * @return          Travel time from first to last, along the tour.
+         */
+        float travel_time_between(std::size_t first, std::size_t last) const {
+            assert(first <= last);
+            assert(last < vertices.size());
+            return prefix_travel_times[last] - prefix_travel_times[first];
+        }
+
+        /**
+         * Gives the vertex immediately preceding the vertex added by an
+         * insertion priced on this tour.
+         */
+        BoostVertex vertex_before(const VertexInsertionPrice& insertion) const {
+            assert(insertion.position < vertices.size());
+            return vertices[insertion.position];
+        }
+
+        /**
+         * Gives the vertex immediately following the vertex added by an
+         * insertion priced on this tour.
+         */
+        BoostVertex vertex_after(const VertexInsertionPrice& insertion) const {
+            assert(insertion.position < vertices.size());
+            return vertices[(insertion.position + 1u) % vertices.size()];
+        }
 
         /**
          * Prints the tour to a png file.
@@ -103,22 +190,62 @@ namespace op {
 
         /**
          * Tries to reduce the travel time with a 2-opt heuristic.
+         *
+         * @return  The edges created by the moves; later moves might have removed some of them.
+         */
+        TourEdgeList do_2opt();
+
+        /**
+         * Tries to reduce the travel time with a 2-opt heuristic which, for
+         * each vertex, only tries to connect it to the vertices in its list
+         * in the proximity map. Vertices whose neighbourhood gave no
+         * improving move are not looked at again (don't-look bits), until
+         * a move changes one of their edges. Moves reverse the segment
+         * between the two edges in place, so each pass is near-linear in
+         * the length of the tour. It is faster, but weaker, than do_2opt().
+         *
+         * @return  The edges created by the moves; later moves might have removed some of them.
+         */
+        TourEdgeList do_2opt_neighbours();
+
+        /**
+         * Tries to reduce the travel time with Or-opt: it moves chains of up
+         * to max_chain_length consecutive vertices (possibly reversing them)
+         * to another edge of the tour, next to one of the neighbours of the
+         * chain's endpoints in the proximity map. It applies the first
+         * improving move it finds, until no chain can be moved profitably.
+         *
+         * @param max_chain_length  Maximum number of vertices in a chain.
+         * @return                  The edges created by the moves; later moves might have removed some of them.
+         */
+        TourEdgeList do_or_opt(std::size_t max_chain_length);
+
+        /**
+         * Tries to reduce the travel time moving single vertices to another
+         * edge of the tour, next to one of their neighbours in the proximity
+         * map. It is Or-opt, with chains of one vertex.
+         *
+         * @return  The edges created by the moves (see do_or_opt()).
          */
-        void do_2opt();
+        TourEdgeList do_relocate() { return do_or_opt(1u); }
 
         /**
          * Removes vertices to make the travel time feasible (heuristically).
          *
-         * @return  The list of removed vertices.
+         * @param new_edges     If not null, the edges created by the removals are appended
+         *                      to it; later removals might have removed some of them.
+         * @return              The list of removed vertices.
          */
-        std::vector<BoostVertex> make_travel_time_feasible_naive();
+        SmallVertexList make_travel_time_feasible_naive(TourEdgeList* new_edges = nullptr);
 
         /**
          * Removes vertices to make the travel time feasible (optimally).
          *
-         * @return  The list of removed vertices.
+         * @param new_edges     If not null, the edges created by the removals are appended
+         *                      to it; later removals might have removed some of them.
+         * @return              The list of removed vertices.
          */
-        std::vector<BoostVertex> make_travel_time_feasible_optimal();
+        SmallVertexList make_travel_time_feasible_optimal(TourEdgeList* new_edges = nullptr);
 
         /**
          * Removes a vertex from the tour. The vertex must be visited
@@ -155,7 +282,7 @@ namespace op {
          * @param vertex_it     Iterator to the vertex to remove.
          * @return              True iff the vertex was removed.
          */
-        bool remove_vertex(std::vector<BoostVertex>::iterator vertex_it);
+        bool remove_vertex(SmallVertexList::iterator vertex_it);
 
         /**
          * Removes a vertex from the tour, by its position (index)
@@ -170,6 +297,32 @@ namespace op {
          */
         bool remove_vertex_by_position(std::size_t position);
 
+        /**
+         * Removes the vertices in positions first, ..., last - 1 from the
+         * tour, in a single pass. Position first must be at least 1, so that
+         * the depot is not removed, and last cannot exceed vertices.size().
+         * The travel time saved is computed in O(1) time, from the prefix
+         * sums of the travel times.
+         *
+         * @param first     Position of the first vertex to remove.
+         * @param last      One past the position of the last vertex to remove.
+         * @return          The edge joining the vertices around the segment (none if nothing was removed).
+         */
+        TourEdgeList remove_segment(std::size_t first, std::size_t last);
+
+        /**
+         * Removes a set of vertices from the tour, compacting the vertices
+         * list in a single pass. The vertices must be visited by the tour,
+         * must be distinct, and cannot include the depot. The travel time
+         * saved is computed once per run of consecutive removed vertices,
+         * from the prefix sums of the travel times.
+         *
+         * @param to_remove     Pointer to the first vertex to remove.
+         * @param n             Number of vertices to remove.
+         * @return              The edges joining the vertices around each run of removed vertices.
+         */
+        TourEdgeList remove_vertices(const VertexIndex* to_remove, std::size_t n);
+
         /**
          * Adds a vertex to the tour. Position must be a valid position,
          * and corresponds to the index of the vertex immediately preceding
@@ -206,6 +359,28 @@ namespace op {
          */
         VertexInsertionPrice price_vertex_insertion(const BoostVertex& vertex, std::size_t position) const;
 
+        /**
+         * Prices the insertion of a vertex at every position of the tour,
+         * appending the prices to a vector in order of position. It gives
+         * the same prices as price_vertex_insertion(), but computes all
+         * travel times from the vertex to the tour in a single batch.
+         *
+         * @param vertex        The vertex.
+         * @param insertions    The vector where to append the prices.
+         */
+        void price_vertex_insertions(const BoostVertex& vertex, std::vector<VertexInsertionPrice>& insertions) const;
+
+        /**
+         * Tells whether an insertion keeps the tour's travel time within the
+         * maximum travel time. The check is exact even when the insertion was
+         * priced with approximate travel times: in that case, insertions close
+         * to the limit are re-priced with exact travel times.
+         *
+         * @param insertion     The insertion, priced on this tour.
+         * @return              True iff the tour after the insertion is feasible.
+         */
+        bool is_insertion_feasible(const VertexInsertionPrice& insertion) const;
+
         /**
          * Checks that the tour is simple, i.e. does not contain repeated vertices.
          *
@@ -222,7 +397,7 @@ namespace op {
         bool is_travel_time_correct();
 
         /**
-         * Checks that the vertices and edges vectors agree.
+         * Checks that the edges given by edges() agree with the vertices.
          * 
          * @return True iff they agree.
          */
@@ -241,7 +416,7 @@ namespace op {
     private:
 
         /**
-         * Calculate the travel time by summing the edges' travel time.
+         * Calculate the travel time by summing the travel times between consecutive vertices.
          */
         void calculate_travel_time();
 
@@ -251,14 +426,43 @@ namespace op {
         void calculate_total_prize();
 
         /**
-         * Calculate the vertex vector from the edge vector.
+         * Rebuilds positions and visited from the vertex vector.
+         */
+        void index_vertices();
+
+        /**
+         * Updates positions for the vertices between two positions.
+         *
+         * @param first     First position to update.
+         * @param last      One past the last position to update.
+         */
+        void update_positions(std::size_t first, std::size_t last);
+
+        /**
+         * Recomputes the prefix sums of the travel times between two positions,
+         * assuming the entries before the first position are correct.
+         *
+         * @param first     First position to update (must be at least 1).
+         * @param last      One past the last position to update.
          */
-        void calculate_vertices_from_edges();
+        void update_prefix_travel_times(std::size_t first, std::size_t last);
 
         /**
-         * Calculate the edge vector from the vertex vector.
+         * Adds a constant to the prefix sums of the travel times, from a
+         * position onwards, e.g. after a change to the tour before that
+         * position which increased its travel time.
+         *
+         * @param first     First position to update.
+         * @param delta     The change in travel time.
+         */
+        void shift_prefix_travel_times(std::size_t first, float delta);
+
+        /**
+         * Calculate the vertex vector from an edge vector.
+         *
+         * @param edges The edges of the tour.
          */
-        void calculate_edges_from_vertices();
+        void calculate_vertices_from_edges(const std::vector<BoostEdge>& edges);
 
         /**
          * Reads a tour from an OPLIB .sol solution.
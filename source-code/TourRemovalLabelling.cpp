@@ -0,0 +1,139 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include "TourRemovalLabelling.h"
+
+namespace op {
+    TourRemovalLabelling::TourRemovalLabelling(const Graph& graph, const SmallVertexList& vertices) :
+        graph{std::experimental::make_observer(&graph)},
+        vertices{vertices},
+        frontier(vertices.size() + 1u),
+        min_travel_time_to_depot(vertices.size() + 1u, 0.0f),
+        remaining_prize(vertices.size() + 1u, 0.0f)
+    {
+        const auto n = vertices.size();
+        std::vector<float> travel_times(n);
+
+        for(auto i = n; i-- > 0u;) {
+            remaining_prize[i] = remaining_prize[i + 1u] + graph.prize(vertices[i]);
+
+            // Position 0 cannot go straight to position n.
+            min_travel_time_to_depot[i] = (i == 0u) ?
+                std::numeric_limits<float>::max() :
+                graph.exact_travel_time(vertices[i], vertices[0u]);
+
+            graph.exact_travel_times_from(vertices[i], vertices.data() + i + 1u, n - i - 1u, travel_times.data());
+
+            for(auto j = i + 1u; j < n; ++j) {
+                min_travel_time_to_depot[i] = std::min(
+                    min_travel_time_to_depot[i],
+                    travel_times[j - i - 1u] + min_travel_time_to_depot[j]
+                );
+            }
+        }
+    }
+
+    void TourRemovalLabelling::add_label(const Label& label) {
+        auto& labels_at_position = frontier[label.position];
+
+        // The last label with no larger travel time has the highest prize among them.
+        const auto after = std::upper_bound(labels_at_position.begin(), labels_at_position.end(), label.travel_time,
+            [&] (float travel_time, std::uint32_t other) { return travel_time < labels[other].travel_time; }
+        );
+
+        if(after != labels_at_position.begin() && labels[*(after - 1)].prize >= label.prize) {
+            return;
+        }
+
+        // Labels with no smaller travel time and no larger prize are dominated.
+        const auto first_dominated = std::lower_bound(labels_at_position.begin(), labels_at_position.end(), label.travel_time,
+            [&] (std::uint32_t other, float travel_time) { return labels[other].travel_time < travel_time; }
+        );
+
+        auto last_dominated = first_dominated;
+
+        while(last_dominated != labels_at_position.end() && labels[*last_dominated].prize <= label.prize) {
+            ++last_dominated;
+        }
+
+        const auto label_id = static_cast<std::uint32_t>(labels.size());
+        labels.push_back(label);
+
+        if(first_dominated == last_dominated) {
+            labels_at_position.insert(first_dominated, label_id);
+        } else {
+            *first_dominated = label_id;
+            labels_at_position.erase(first_dominated + 1, last_dominated);
+        }
+    }
+
+    std::optional<SmallVertexList> TourRemovalLabelling::vertices_to_remove(float best_known_prize) {
+        const auto n = vertices.size();
+        const auto max_travel_time = graph->max_travel_time;
+        const auto no_label = std::numeric_limits<std::uint32_t>::max();
+
+        if(n < 2u) { return std::nullopt; }
+
+        std::vector<float> travel_times(n);
+        auto best_prize = best_known_prize;
+        auto best_label = no_label;
+
+        labels.clear();
+        add_label({0.0f, graph->prize(vertices[0u]), no_label, 0u});
+
+        for(auto i = 0u; i < n; ++i) {
+            if(frontier[i].empty()) { continue; }
+
+            graph->exact_travel_times_from(vertices[i], vertices.data() + i + 1u, n - i - 1u, travel_times.data());
+            travel_times[n - i - 1u] = graph->exact_travel_time(vertices[i], vertices[0u]);
+
+            // Labels at later positions only are added, so the frontier at i does not change.
+            for(const auto label_id : frontier[i]) {
+                const auto label = labels[label_id];
+
+                for(auto j = i + 1u; j <= n; ++j) {
+                    if(i == 0u && j == n) { break; }
+
+                    // Remaining prize decreases with j: skipping more vertices cannot help.
+                    if(label.prize + remaining_prize[j] <= best_prize) { break; }
+
+                    const auto travel_time = label.travel_time + travel_times[j - i - 1u];
+
+                    if(travel_time + min_travel_time_to_depot[j] > max_travel_time) { continue; }
+
+                    const auto prize = label.prize + (j < n ? graph->prize(vertices[j]) : 0.0f);
+
+                    if(j == n) {
+                        best_prize = prize;
+                        best_label = static_cast<std::uint32_t>(labels.size());
+                        labels.push_back({travel_time, prize, label_id, static_cast<std::uint32_t>(n)});
+                    } else {
+                        add_label({travel_time, prize, label_id, static_cast<std::uint32_t>(j)});
+                    }
+                }
+            }
+        }
+
+        if(best_label == no_label) { return std::nullopt; }
+
+        std::vector<bool> kept(n, false);
+
+        for(auto label_id = labels[best_label].predecessor; label_id != no_label; label_id = labels[label_id].predecessor) {
+            kept[labels[label_id].position] = true;
+        }
+
+        assert(kept[0u]);
+
+        SmallVertexList removed_vertices;
+
+        for(auto i = 1u; i < n; ++i) {
+            if(!kept[i]) { removed_vertices.push_back(vertices[i]); }
+        }
+
+        return removed_vertices;
+    }
+}
@@ -5,105 +5,116 @@
 #ifndef OP_TOURREMOVALLABELLING_H
 #define OP_TOURREMOVALLABELLING_H
 
-#include <boost/property_map/property_map.hpp>
-#include <type_traits>
+#include <experimental/memory>
+#include <cstdint>
+#include <optional>
+#include <vector>
 #include "Graph.h"
 
 namespace op {
-    struct JVertexProperty {
-        std::size_t id;
-        BoostVertex original_v;
-        float prize;
-        JVertexProperty() = default;
-        JVertexProperty(std::size_t i, BoostVertex o, float p) : id{i}, original_v{o}, prize{p} {}
+    /**
+     * Labelling algorithm which finds, among the subsequences of a tour
+     * which start from the depot and whose travel time does not exceed the
+     * maximum travel time, one collecting the highest prize. That is, it
+     * chooses optimally which vertices to remove from a tour to make it
+     * feasible, without changing the order of the others.
+     *
+     * Positions 0, ..., n - 1 of the tour are the vertices of an acyclic
+     * graph, together with position n, a copy of the depot where all paths
+     * end. Labels are stored in flat arrays, and positions are processed in
+     * order, extending their labels to all later positions. A label is
+     * discarded if another label at the same position has no larger travel
+     * time and no smaller prize, if it cannot reach position n within the
+     * maximum travel time, or if even collecting the prize of all remaining
+     * positions would not beat the best prize known.
+     */
+    class TourRemovalLabelling {
+        /**
+         * Label of a path from position 0 to some position.
+         */
+        struct Label {
+            /**
+             * Travel time of the path.
+             */
+            float travel_time;
+
+            /**
+             * Prize collected along the path.
+             */
+            float prize;
+
+            /**
+             * Index of the label it was extended from, in labels.
+             */
+            std::uint32_t predecessor;
+
+            /**
+             * Position where the path ends.
+             */
+            std::uint32_t position;
+        };
+
+        /**
+         * Non-owning pointer to the graph containing the tour.
+         */
+        std::experimental::observer_ptr<const Graph> graph;
+
+        /**
+         * Vertices of the tour, starting from the depot.
+         */
+        const SmallVertexList& vertices;
+
+        /**
+         * All labels created, including those later found to be dominated.
+         */
+        std::vector<Label> labels;
+
+        /**
+         * Non-dominated labels ending at each position, as indices in labels,
+         * sorted by increasing travel time (and, therefore, increasing prize).
+         */
+        std::vector<std::vector<std::uint32_t>> frontier;
+
+        /**
+         * Entry i is the minimum travel time from position i back to the depot,
+         * visiting any subsequence of the positions in between.
+         */
+        std::vector<float> min_travel_time_to_depot;
+
+        /**
+         * Entry i is the total prize of the vertices from position i onwards.
+         */
+        std::vector<float> remaining_prize;
+
+        /**
+         * Adds a label to the frontier of its position, unless it is dominated,
+         * and removes the labels it dominates.
+         *
+         * @param label The label.
+         */
+        void add_label(const Label& label);
+
+    public:
+        /**
+         * Prepares the labelling for a tour.
+         *
+         * @param graph     The graph containing the tour.
+         * @param vertices  The vertices of the tour, starting from the depot.
+         */
+        TourRemovalLabelling(const Graph& graph, const SmallVertexList& vertices);
+
+        /**
+         * Runs the labelling. Subsequences visit at least one vertex other
+         * than the depot, as long as the tour does.
+         *
+         * @param best_known_prize  Prize of a feasible subsequence known
+         *                          in advance, used for bounding.
+         * @return                  The vertices to remove, if a subsequence
+         *                          collecting a higher prize than the best
+         *                          known exists; nothing otherwise.
+         */
+        std::optional<SmallVertexList> vertices_to_remove(float best_known_prize);
     };
-
-    struct JEdgeProperty {
-        std::size_t id;
-        float distance;
-        JEdgeProperty() = default;
-        JEdgeProperty(std::size_t i, float d) : id{i}, distance{d} {}
-    };
-
-    using JGraph = boost::adjacency_list<boost::vecS, boost::vecS, boost::directedS, JVertexProperty, JEdgeProperty, float>;
-    using JVertex = boost::graph_traits<JGraph>::vertex_descriptor;
-    using JEdge = boost::graph_traits<JGraph>::edge_descriptor;
-
-    struct JLabel {
-        float distance;
-        float prize;
-
-        JLabel(float d, float p) : distance{d}, prize{p} {}
-        bool operator==(const JLabel& other) const {
-            return std::fabs(distance - other.distance) < 1e-6f && std::fabs(prize - other.prize) < 1e-6f;
-        }
-        bool operator!=(const JLabel& other) const {
-            return !(*this == other);
-        }
-        bool operator<(const JLabel& other) const {
-            return (distance <= other.distance) && (prize <= other.prize) && (*this != other);
-        }
-    };
-
-    struct JLabelExtender {
-        bool operator()(const JGraph& jgraph, JLabel& new_label, const JLabel& label, const JEdge& edge) const {
-            const auto& ttime = jgraph[edge].distance;
-
-            if(label.distance + ttime > jgraph[boost::graph_bundle]) {
-                return false;
-            }
-
-            const auto& dest = boost::target(edge, jgraph);
-
-            new_label.distance = label.distance + ttime;
-            new_label.prize = label.prize + jgraph[dest].prize;
-
-            return true;
-        }
-    };
-
-    struct JVFunctor {
-        const JGraph& jgraph;
-        JVFunctor(const JGraph& j) : jgraph{j} {}
-        using result_type = std::size_t;
-        result_type operator()(const JVertex& v) const {
-            return jgraph[v].id;
-        }
-    };
-
-    struct JEFunctor {
-        const JGraph& jgraph;
-        JEFunctor(const JGraph& j) : jgraph{j} {}
-        using result_type = std::size_t;
-        result_type operator()(const JEdge& e) const {
-            return jgraph[e].id;
-        }
-    };
-
-    template<class Fn, class Arg>
-    struct FnPM {
-        const Fn& fn;
-        using value_type = typename std::result_of<Fn(Arg)>::type;
-        FnPM(const Fn& fn) : fn{fn} {}
-        friend value_type get(const FnPM& pm, const Arg& arg) { return pm.fn(arg); }
-        value_type operator[](const Arg& arg) const { return fn(arg); }
-    };
-
-    template<typename Arg, typename Fn>
-    FnPM<Fn, Arg> make_property_map(const Fn &f) {
-        return FnPM<Fn, Arg>(f);
-    }
 }
 
-namespace boost {
-    template<typename Fn, typename Arg>
-    struct property_traits<op::FnPM<Fn, Arg>> {
-        using value_type = typename std::result_of<Fn(Arg)>::type;
-        using reference = value_type;
-        using key_type = Arg;
-        using category = readable_property_map_tag;
-    };
-}
-
-
 #endif //OP_TOURREMOVALLABELLING_H
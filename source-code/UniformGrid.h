@@ -0,0 +1,170 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#ifndef OP_UNIFORMGRID_H
+#define OP_UNIFORMGRID_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+#include "GraphTypes.h"
+
+namespace op {
+    /**
+     * Spatial index which partitions the bounding box of the points into
+     * square cells of equal size. The points of each cell are stored
+     * contiguously, so a box query only scans the cells it overlaps. It
+     * works best when the points are spread evenly, and is built in
+     * linear time.
+     */
+    class UniformGrid {
+        /**
+         * Smallest coordinates among the points.
+         */
+        float min_x = 0.0f, min_y = 0.0f;
+
+        /**
+         * Side of a cell.
+         */
+        float cell_size = 1.0f;
+
+        /**
+         * Number of columns and rows of cells.
+         */
+        std::size_t n_cols = 0u, n_rows = 0u;
+
+        /**
+         * Position in values of the first point of each cell, plus one past the end.
+         */
+        std::vector<std::size_t> cell_offsets;
+
+        /**
+         * Points, sorted by cell (row by row).
+         */
+        std::vector<BoostTreeValue> values;
+
+        /**
+         * Column containing an x-coordinate (clamped to the grid).
+         */
+        std::size_t col(float x) const {
+            const auto c = std::floor((x - min_x) / cell_size);
+            return c <= 0.0f ? 0u : std::min(n_cols - 1u, static_cast<std::size_t>(c));
+        }
+
+        /**
+         * Row containing a y-coordinate (clamped to the grid).
+         */
+        std::size_t row(float y) const {
+            const auto r = std::floor((y - min_y) / cell_size);
+            return r <= 0.0f ? 0u : std::min(n_rows - 1u, static_cast<std::size_t>(r));
+        }
+
+    public:
+
+        /**
+         * Builds an empty grid.
+         */
+        UniformGrid() = default;
+
+        /**
+         * Builds the grid over a range of points.
+         *
+         * @tparam It               Iterator type, with BoostTreeValue as value type.
+         * @param  first            Start of the range.
+         * @param  last             End of the range.
+         * @param  points_per_cell  Average number of points per cell, if the points were spread evenly.
+         */
+        template<typename It>
+        UniformGrid(It first, It last, float points_per_cell = 2.0f) : values(first, last) {
+            if(values.empty()) { return; }
+
+            float max_x = values.front().first.x(), max_y = values.front().first.y();
+            min_x = max_x;
+            min_y = max_y;
+
+            for(const auto& value : values) {
+                min_x = std::min(min_x, value.first.x());
+                min_y = std::min(min_y, value.first.y());
+                max_x = std::max(max_x, value.first.x());
+                max_y = std::max(max_y, value.first.y());
+            }
+
+            const auto width = std::max(max_x - min_x, 1e-6f);
+            const auto height = std::max(max_y - min_y, 1e-6f);
+            const auto n = static_cast<float>(values.size());
+
+            cell_size = std::sqrt(width * height * points_per_cell / n);
+
+            // Do not create many more cells than points, when the points lie on a line.
+            cell_size = std::max(cell_size, std::max(width, height) / n);
+
+            n_cols = static_cast<std::size_t>(width / cell_size) + 1u;
+            n_rows = static_cast<std::size_t>(height / cell_size) + 1u;
+
+            // Counting sort of the points by cell.
+            std::vector<std::size_t> cells(values.size());
+            cell_offsets.assign(n_cols * n_rows + 1u, 0u);
+
+            for(auto i = 0u; i < values.size(); ++i) {
+                cells[i] = row(values[i].first.y()) * n_cols + col(values[i].first.x());
+                ++cell_offsets[cells[i] + 1u];
+            }
+
+            for(auto c = 0u; c + 1u < cell_offsets.size(); ++c) {
+                cell_offsets[c + 1u] += cell_offsets[c];
+            }
+
+            std::vector<BoostTreeValue> sorted(values.size());
+            auto next = cell_offsets;
+
+            for(auto i = 0u; i < values.size(); ++i) {
+                sorted[next[cells[i]]++] = values[i];
+            }
+
+            values = std::move(sorted);
+        }
+
+        /**
+         * Number of points in the grid.
+         */
+        std::size_t size() const { return values.size(); }
+
+        /**
+         * Calls fn(value) for each point strictly inside a box, with the
+         * same semantics as boost::geometry::index::within for points.
+         *
+         * @tparam Fn   Type of the function.
+         * @param  box  The box.
+         * @param  fn   The function.
+         */
+        template<typename Fn>
+        void for_each_within(const BoostBox& box, Fn&& fn) const {
+            if(values.empty()) { return; }
+
+            const auto bx0 = box.min_corner().x(), by0 = box.min_corner().y();
+            const auto bx1 = box.max_corner().x(), by1 = box.max_corner().y();
+
+            const auto c0 = col(bx0), c1 = col(bx1);
+            const auto r0 = row(by0), r1 = row(by1);
+
+            for(auto r = r0; r <= r1; ++r) {
+                // Cells in the same row are contiguous.
+                const auto first = cell_offsets[r * n_cols + c0];
+                const auto last = cell_offsets[r * n_cols + c1 + 1u];
+
+                for(auto i = first; i < last; ++i) {
+                    const auto& p = values[i].first;
+
+                    if(bx0 < p.x() && p.x() < bx1 && by0 < p.y() && p.y() < by1) {
+                        fn(values[i]);
+                    }
+                }
+            }
+        }
+    };
+}
+
+#endif //OP_UNIFORMGRID_H
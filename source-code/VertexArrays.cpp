@@ -0,0 +1,32 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#include "VertexArrays.h"
+
+#include <as/graph.h>
+#include <vector>
+
+namespace op {
+    VertexArrays::VertexArrays(const BoostGraph& g) {
+        const auto n = boost::num_vertices(g);
+
+        std::vector<float> vxs(n), vys(n), vprizes(n);
+        std::vector<std::uint64_t> bitmap(n_bitmap_words(n), 0u);
+
+        for(const auto& v : as::graph::vertices(g)) {
+            vxs[v] = g[v].x;
+            vys[v] = g[v].y;
+            vprizes[v] = g[v].prize;
+
+            if(g[v].reachable) {
+                bitmap[v / bits_per_word] |= std::uint64_t{1u} << (v % bits_per_word);
+            }
+        }
+
+        xs = Buffer<float>(std::move(vxs));
+        ys = Buffer<float>(std::move(vys));
+        prizes = Buffer<float>(std::move(vprizes));
+        reachable = Buffer<std::uint64_t>(std::move(bitmap));
+    }
+}
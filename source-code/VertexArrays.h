@@ -0,0 +1,86 @@
+//
+// Created by alberto on 16/10/26.
+//
+
+#ifndef OP_VERTEXARRAYS_H
+#define OP_VERTEXARRAYS_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include "Buffer.h"
+#include "GraphTypes.h"
+
+namespace op {
+    /**
+     * Copy of the vertex properties of the boost graph, stored as one
+     * contiguous array per property (structure of arrays), indexed by
+     * vertex. Loops which read a single property of many vertices (e.g.
+     * the prize, when pricing insertions) scan memory linearly, instead
+     * of jumping between the bundles stored in the adjacency list.
+     */
+    struct VertexArrays {
+        /**
+         * Number of bits in each word of the reachability bitmap.
+         */
+        static constexpr std::size_t bits_per_word = 64u;
+
+        /**
+         * Vertex x-coordinates.
+         */
+        Buffer<float> xs;
+
+        /**
+         * Vertex y-coordinates.
+         */
+        Buffer<float> ys;
+
+        /**
+         * Vertex prizes.
+         */
+        Buffer<float> prizes;
+
+        /**
+         * Bitmap of reachable vertices: vertex v is reachable iff bit
+         * v % 64 of word v / 64 is set.
+         */
+        Buffer<std::uint64_t> reachable;
+
+        /**
+         * Builds empty arrays.
+         */
+        VertexArrays() = default;
+
+        /**
+         * Copies the vertex properties of a boost graph.
+         *
+         * @param g The boost graph.
+         */
+        explicit VertexArrays(const BoostGraph& g);
+
+        /**
+         * Builds the arrays from existing buffers, e.g. mapped from a cache file.
+         */
+        VertexArrays(Buffer<float> xs, Buffer<float> ys, Buffer<float> prizes, Buffer<std::uint64_t> reachable) :
+            xs{std::move(xs)}, ys{std::move(ys)}, prizes{std::move(prizes)}, reachable{std::move(reachable)} {}
+
+        /**
+         * Number of words needed for the reachability bitmap of n vertices.
+         */
+        static std::size_t n_bitmap_words(std::size_t n) { return (n + bits_per_word - 1u) / bits_per_word; }
+
+        /**
+         * Tells whether a vertex is reachable.
+         *
+         * @param v The vertex.
+         * @return  True iff it is reachable.
+         */
+        bool is_reachable(BoostVertex v) const {
+            assert(v / bits_per_word < reachable.size());
+            return (reachable[v / bits_per_word] >> (v % bits_per_word)) & 1u;
+        }
+    };
+}
+
+#endif //OP_VERTEXARRAYS_H
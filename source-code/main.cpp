@@ -16,6 +16,7 @@
 #include "GreedyHeuristic.h"
 #include "PrintParamsCsv.h"
 #include "GraphFeatures.h"
+#include "SpatialIndexBenchmark.h"
 #include "palns/PALNSSolver.h"
 
 namespace fs = std::experimental::filesystem;
@@ -36,6 +37,60 @@ namespace {
         }
     }
 
+    GraphOptions graph_options() {
+        GraphOptions options;
+
+        if(parser["coordinate-only"].was_set()) {
+            options.materialise_edges = false;
+
+            // Without edges, the aim is to save memory: do not store a dense matrix,
+            // unless asked to.
+            options.distance_storage = DistanceOracle::Backend::Coordinates;
+        }
+
+        if(parser["distance-storage"].was_set()) {
+            const std::string storage = parser["distance-storage"].get().string;
+
+            if(storage == "dense") {
+                options.distance_storage = DistanceOracle::Backend::DenseMatrix;
+            } else if(storage == "triangular") {
+                options.distance_storage = DistanceOracle::Backend::TriangularMatrix;
+            } else if(storage == "coordinates") {
+                options.distance_storage = DistanceOracle::Backend::Coordinates;
+            } else if(storage == "quantised") {
+                options.distance_storage = DistanceOracle::Backend::QuantisedTriangularMatrix;
+            } else {
+                std::cerr << console::error << "Unrecognised distance storage: " << storage << and_die();
+            }
+        }
+
+        if(parser["prune-edges"].was_set()) {
+            options.prune_infeasible_edges = true;
+        }
+
+        if(parser["renumber-vertices"].was_set()) {
+            options.renumber_vertices = true;
+        }
+
+        if(parser["proximity-neighbours"].was_set()) {
+            options.n_proximity_neighbours = parser["proximity-neighbours"].get().u32;
+
+            if(options.n_proximity_neighbours < 1u) {
+                std::cerr << console::error << "The number of proximity neighbours must be at least 1." << and_die();
+            }
+        }
+
+        if(parser["cache-file"].was_set()) {
+            options.cache_file = parser["cache-file"].get().string;
+        }
+
+        if(parser["graph-threads"].was_set()) {
+            options.n_threads = std::max<std::size_t>(1u, parser["graph-threads"].get().u32);
+        }
+
+        return options;
+    }
+
     void try_print_graph(const Graph& g) {
         for(const auto& of : parser["output-file"]) {
             const fs::path output_file(of.string);
@@ -144,6 +199,10 @@ namespace {
         std::cerr << inst_graph.instance_name() << "," << duration_cast<duration<float>>(end_time - start_time).count() << "\n";
     }
 
+    void bench_spatial() {
+        benchmark_spatial_indices(inst_graph);
+    }
+
     void print_solution() {
         ensure_flag("solution-file");
         ensure_flag("output-file");
@@ -183,7 +242,7 @@ namespace {
         std::random_device rd;
         std::mt19937 mt{rd()};
         std::uniform_int_distribution<std::size_t> dist(1u, max_tour_length);
-        std::vector<BoostVertex> all_custs(inst_graph.n_vertices - 1u);
+        VertexList all_custs(inst_graph.n_vertices - 1u);
         std::iota(all_custs.begin(), all_custs.end(), 1u);
 
         std::vector<PALNSSolution> s1(n_tours), s2(n_tours);
@@ -191,7 +250,7 @@ namespace {
             const auto tour_length = dist(mt);
             const auto customers = rnd::sample(all_custs, tour_length, mt);
 
-            std::vector<BoostVertex> vertices = {0u};
+            SmallVertexList vertices = {0u};
             vertices.insert(vertices.end(), customers.begin(), customers.end());
 
             const Tour t{&inst_graph, vertices};
@@ -199,7 +258,7 @@ namespace {
             s2[i] = PALNSSolution(t, &params);
         }
 
-        std::printf("%3zu, ", Graph::n_proximity_neighbours);
+        std::printf("%3zu, ", inst_graph.n_proximity_neighbours);
 
         GreedyRepair g1{&params, true};
         const auto t1 = high_resolution_clock::now();
@@ -257,7 +316,7 @@ namespace {
 int main(int argc, char** argv) {
     parser["action"]
         .abbreviation('a')
-        .description("Action to perform: [print-graph|print-clustered|time-cluster|print-solution|print-features|greedy|test-repair|alns]. Mandatory.")
+        .description("Action to perform: [print-graph|print-clustered|time-cluster|bench-spatial|print-solution|print-features|greedy|test-repair|alns]. Mandatory.")
         .type(po::string);
 
     parser["output-file"]
@@ -296,6 +355,31 @@ int main(int argc, char** argv) {
         .description("File where ALNS can save statistics on the usage of destroy/repair methods. Optional for action alns. Ignored otherwise.")
         .type(po::string);
 
+    parser["distance-storage"]
+        .description("How travel times are stored: [dense|triangular|coordinates|quantised]. Optional, defaults to dense, or to coordinates with --coordinate-only.")
+        .type(po::string);
+
+    parser["coordinate-only"]
+        .description("Do not store the graph edges, to save memory on large instances. Travel times are computed from the coordinates, unless --distance-storage is given. Not compatible with the branch-and-cut solver. Optional.");
+
+    parser["prune-edges"]
+        .description("Remove the edges which cannot be part of any feasible tour, to speed up the search on instances with a tight travel time limit. Optional.");
+
+    parser["renumber-vertices"]
+        .description("Renumber the vertices along a Hilbert curve, to improve memory locality. Solution files still use the ids of the instance file. Optional.");
+
+    parser["proximity-neighbours"]
+        .description("Number of closest neighbours stored for each vertex; at least 1. Optional, defaults to 20.")
+        .type(po::u32);
+
+    parser["cache-file"]
+        .description("Binary cache of the preprocessed graph: it is read if valid, and written otherwise. Graph edges are not cached, so loading is only fast with --coordinate-only. Optional.")
+        .type(po::string);
+
+    parser["graph-threads"]
+        .description("Number of threads used to build the graph. Optional, defaults to the number of hardware threads.")
+        .type(po::u32);
+
     parser["help"]
         .abbreviation('h')
         .description("Prints this help text.")
@@ -308,7 +392,7 @@ int main(int argc, char** argv) {
 
     ensure_flag("instance-file");
     instance_file = parser["instance-file"].get().string;
-    inst_graph = Graph(instance_file);
+    inst_graph = Graph(instance_file, graph_options());
 
     if(action == "print-graph") {
         print_graph();
@@ -316,6 +400,8 @@ int main(int argc, char** argv) {
         print_clustered();
     } else if(action == "time-cluster") {
         time_cluster();
+    } else if(action == "bench-spatial") {
+        bench_spatial();
     } else if(action == "print-solution") {
         print_solution();
     } else if(action == "print-features") {
@@ -3,6 +3,7 @@
 //
 
 #include "PALNSProblemParams.h"
+#include "../LinKernighan.h"
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <iostream>
@@ -33,7 +34,8 @@ namespace op {
         heuristic{false},
         intermediate_infeasible{true},
         use_2opt_before_restoring_feasibility{true},
-        restore_feasibility_optimal{0.0f}
+        restore_feasibility_optimal{0.0f},
+        linked_tour_min_size{2000u}
     {}
 
     PALNSProblemParams::InitialSolutionParams::InitialSolutionParams() :
@@ -44,10 +46,25 @@ namespace op {
 
     PALNSProblemParams::LocalSearchParams::LocalSearchParams() :
         use_2opt{true},
+        neighbour_2opt_min_size{1000u},
+        use_or_opt{false},
+        or_opt_max_chain_length{3u},
         use_tsp{false},
+        tsp_max_trials{0u},
+        tsp_time_limit{1.0},
+        tsp_n_neighbours{10u},
         fill_tour{true}
     {}
 
+    LinKernighanOptions PALNSProblemParams::LocalSearchParams::tsp_options(unsigned int seed) const {
+        LinKernighanOptions options;
+        options.max_trials = tsp_max_trials;
+        options.time_limit = tsp_time_limit;
+        options.n_neighbours = tsp_n_neighbours;
+        options.seed = seed;
+        return options;
+    }
+
     PALNSProblemParams::PALNSProblemParams(std::experimental::filesystem::path params_file) :
         destroy{}, repair{}, initial_solution{}, local_search{}
     {
@@ -72,6 +89,7 @@ namespace op {
         READPARAM(repair.intermediate_infeasible, bool)
         READPARAM(repair.use_2opt_before_restoring_feasibility, bool)
         READPARAM(repair.restore_feasibility_optimal, float)
+        READPARAM(repair.linked_tour_min_size, std::size_t)
 
         READPARAM(initial_solution.use_clustering, bool)
         READPARAM(initial_solution.use_mip, bool)
@@ -79,7 +97,13 @@ namespace op {
         READPARAM(initial_solution.vertex_order, std::string)
 
         READPARAM(local_search.use_2opt, bool)
+        READPARAM(local_search.neighbour_2opt_min_size, std::size_t)
+        READPARAM(local_search.use_or_opt, bool)
+        READPARAM(local_search.or_opt_max_chain_length, std::size_t)
         READPARAM(local_search.use_tsp, bool)
+        READPARAM(local_search.tsp_max_trials, std::size_t)
+        READPARAM(local_search.tsp_time_limit, double)
+        READPARAM(local_search.tsp_n_neighbours, std::size_t)
         READPARAM(local_search.fill_tour, bool)
     }
 }
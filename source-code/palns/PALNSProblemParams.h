@@ -9,6 +9,8 @@
 #include <experimental/filesystem>
 
 namespace op {
+    struct LinKernighanOptions;
+
     // Problem-specific PALNS parameters.
     struct PALNSProblemParams {
         struct DestroyMethodsParams {
@@ -74,6 +76,13 @@ namespace op {
              */
             float restore_feasibility_optimal;
 
+            /**
+             * Minimum number of vertices in a tour, for the greedy repair
+             * to work on a linked-list representation of it (see LinkedTour)
+             * rather than on the vertex vector.
+             */
+            std::size_t linked_tour_min_size;
+
             RepairMethodsParams();
         };
 
@@ -108,11 +117,47 @@ namespace op {
              */
             bool use_2opt;
 
+            /**
+             * Minimum number of vertices in a tour, for 2-opt to only try
+             * moves between vertices close to each other in the proximity
+             * map (see Tour::do_2opt_neighbours).
+             */
+            std::size_t neighbour_2opt_min_size;
+
+            /**
+             * Use Or-opt as a local-search procedure, after 2-opt or the TSP.
+             * Disabled by default, so that default trajectories are unchanged.
+             */
+            bool use_or_opt;
+
+            /**
+             * Maximum number of consecutive vertices moved together by Or-opt.
+             * With chains of one vertex, Or-opt only relocates single vertices.
+             */
+            std::size_t or_opt_max_chain_length;
+
             /**
              * Solve the TSP over the tour vertices as a local-search procedure.
              */
             bool use_tsp;
 
+            /**
+             * Maximum number of kicks of the TSP heuristic. If zero, the
+             * number of vertices of the TSP is used.
+             */
+            std::size_t tsp_max_trials;
+
+            /**
+             * Maximum time spent by the TSP heuristic on kicks, in seconds.
+             */
+            double tsp_time_limit;
+
+            /**
+             * Number of candidate neighbours of each vertex, for the moves
+             * of the TSP heuristic.
+             */
+            std::size_t tsp_n_neighbours;
+
             /**
              * Tells wether we should try to insert unassigned vertices to
              * a tour after shortening it with local search.
@@ -120,6 +165,15 @@ namespace op {
             bool fill_tour;
 
             LocalSearchParams();
+
+            /**
+             * Builds the options of the TSP heuristic (used both in the local
+             * search and in the graph reductions) from these parameters.
+             *
+             * @param seed  Seed for the kicks of the TSP heuristic.
+             * @return      The options of the TSP heuristic.
+             */
+            LinKernighanOptions tsp_options(unsigned int seed) const;
         };
 
         DestroyMethodsParams destroy;
@@ -11,13 +11,14 @@ namespace op {
     PALNSSolution::PALNSSolution(const Graph& graph, const PALNSProblemParams *const params) :
         graph{std::experimental::make_observer(&graph)},
         params{params},
-        tour{Tour(&graph, std::vector<BoostVertex>{0u})}
+        tour{Tour(&graph, SmallVertexList{0u})},
+        free_vertex_positions(graph.n_vertices, 0u)
     {
         for(const auto& vertex : as::graph::vertices(graph.g)) {
             if(!graph.g[vertex].depot &&
-                graph.g[vertex].reachable)
+                graph.is_reachable(vertex))
             {
-                free_vertices.push_back(vertex);
+                push_free_vertex(vertex);
             }
         }
 
@@ -27,16 +28,15 @@ namespace op {
     PALNSSolution::PALNSSolution(Tour tour, const PALNSProblemParams *const params) :
         graph{tour.graph},
         params{params},
-        tour{tour}
+        tour{tour},
+        free_vertex_positions(graph->n_vertices, 0u)
     {
-        using as::containers::contains;
-
         for(const auto& vertex : as::graph::vertices(graph->g)) {
             if(!graph->g[vertex].depot &&
-                graph->g[vertex].reachable &&
-               !contains(tour.vertices, vertex))
+                graph->is_reachable(vertex) &&
+               !this->tour.visits_vertex(vertex))
             {
-                free_vertices.push_back(vertex);
+                push_free_vertex(vertex);
             }
         }
 
@@ -57,27 +57,56 @@ namespace op {
         assert(tour.visits_vertex(vertex));
         assert(!contains(free_vertices, vertex));
 
+        const auto position = tour.position_of(vertex);
+        const auto vertex_before = tour.vertices[position - 1u];
+        const auto vertex_after = tour.vertices[(position + 1u) % tour.vertices.size()];
+
         // If the tour only contained one non-depot vertex, remove_vertex will not remove it.
         if(tour.remove_vertex(vertex)) {
-            free_vertices.push_back(vertex);
+            push_free_vertex(vertex);
             assert(!tour.visits_vertex(vertex));
+
+            update_insertion_cache({{vertex_before, vertex_after}});
         }
 
         assert(free_vertices.size() + tour.vertices.size() == graph->n_reachable_vertices);
     }
 
     bool PALNSSolution::remove_vertex_if_present(BoostVertex vertex) {
-        if(tour.remove_vertex_if_present(vertex)) {
-            free_vertices.push_back(vertex);
-
-            assert(!tour.visits_vertex(vertex));
-            assert(free_vertices.size() + tour.vertices.size() == graph->n_reachable_vertices);
+        if(tour.visits_vertex(vertex)) {
+            remove_vertex(vertex);
 
-            return true;
+            return !tour.visits_vertex(vertex);
         }
         return false;
     }
 
+    void PALNSSolution::remove_segment(std::size_t first, std::size_t last) {
+        assert(first > 0u);
+        assert(first <= last);
+        assert(last <= tour.vertices.size());
+
+        for(auto position = first; position < last; ++position) {
+            push_free_vertex(tour.vertices[position]);
+        }
+
+        update_insertion_cache(tour.remove_segment(first, last));
+
+        assert(free_vertices.size() + tour.vertices.size() == graph->n_reachable_vertices);
+    }
+
+    void PALNSSolution::remove_vertices(const VertexIndex* to_remove, std::size_t n) {
+        const auto new_edges = tour.remove_vertices(to_remove, n);
+
+        for(auto i = 0u; i < n; ++i) {
+            push_free_vertex(to_remove[i]);
+        }
+
+        update_insertion_cache(new_edges);
+
+        assert(free_vertices.size() + tour.vertices.size() == graph->n_reachable_vertices);
+    }
+
     void PALNSSolution::add_vertex(BoostVertex vertex, std::size_t position) {
         using as::containers::contains;
 
@@ -85,23 +114,56 @@ namespace op {
         assert(position < tour.vertices.size());
         assert(contains(free_vertices, vertex));
 
-        tour.add_vertex(vertex, position);
+        const auto vertex_before = static_cast<VertexIndex>(tour.vertices[position]);
+        const auto vertex_after = static_cast<VertexIndex>(tour.vertices[(position + 1u) % tour.vertices.size()]);
 
-        free_vertices.erase(
-            std::remove(
-                free_vertices.begin(),
-                free_vertices.end(),
-                vertex
-            ),
-            free_vertices.end()
-        );
+        erase_free_vertex(free_vertex_index(vertex));
+
+        tour.add_vertex(vertex, position);
+        update_insertion_cache({{vertex_before, static_cast<VertexIndex>(vertex)}, {static_cast<VertexIndex>(vertex), vertex_after}});
 
         assert(tour.visits_vertex(vertex));
         assert(!contains(free_vertices, vertex));
         assert(free_vertices.size() + tour.vertices.size() == graph->n_reachable_vertices);
     }
 
+    void PALNSSolution::set_tour(Tour new_tour) {
+        // The old tour is moved, not copied: it is only needed to find the new edges.
+        const Tour old_tour = std::move(tour);
+        tour = std::move(new_tour);
+
+        // Remove the vertices now in the tour, along with their cache entries.
+        std::size_t n_kept = 0u;
+
+        for(auto i = 0u; i < free_vertices.size(); ++i) {
+            if(!tour.visits_vertex(free_vertices[i])) {
+                free_vertices[n_kept] = free_vertices[i];
+                free_vertex_positions[free_vertices[n_kept]] = static_cast<VertexIndex>(n_kept);
+                insertion_cache[n_kept] = insertion_cache[i];
+                ++n_kept;
+            }
+        }
+
+        free_vertices.resize(n_kept);
+        insertion_cache.resize(n_kept);
+
+        for(const auto& vertex : old_tour.vertices) {
+            if(!tour.visits_vertex(vertex)) {
+                push_free_vertex(vertex);
+            }
+        }
+
+        update_insertion_cache(old_tour);
+
+        assert(free_vertices.size() + tour.vertices.size() == graph->n_reachable_vertices);
+    }
+
     namespace {
+        bool on_same_edge(const CachedInsertion& i1, const CachedInsertion& i2) {
+            return (i1.vertex_before == i2.vertex_before && i1.vertex_after == i2.vertex_after) ||
+                   (i1.vertex_before == i2.vertex_after && i1.vertex_after == i2.vertex_before);
+        }
+
         float c_style_rand_01() {
             return static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
         }
@@ -110,19 +172,20 @@ namespace op {
     void PALNSSolution::make_travel_time_feasible() {
         assert(params);
 
-        std::vector<BoostVertex> removed_vertices;
+        SmallVertexList removed_vertices;
+        TourEdgeList new_edges;
 
         if(c_style_rand_01() < params->repair.restore_feasibility_optimal) {
-            removed_vertices = tour.make_travel_time_feasible_optimal();
+            removed_vertices = tour.make_travel_time_feasible_optimal(&new_edges);
         } else {
-            removed_vertices = tour.make_travel_time_feasible_naive();
+            removed_vertices = tour.make_travel_time_feasible_naive(&new_edges);
         }
 
-        free_vertices.insert(
-          free_vertices.end(),
-          removed_vertices.begin(),
-          removed_vertices.end()
-        );
+        for(const auto& vertex : removed_vertices) {
+            push_free_vertex(vertex);
+        }
+
+        update_insertion_cache(new_edges);
 
         assert(std::none_of(
             removed_vertices.begin(), removed_vertices.end(),
@@ -131,13 +194,262 @@ namespace op {
         assert(free_vertices.size() + tour.vertices.size() == graph->n_reachable_vertices);
     }
 
+    void PALNSSolution::do_2opt() {
+        if(params && tour.vertices.size() >= params->local_search.neighbour_2opt_min_size) {
+            update_insertion_cache(tour.do_2opt_neighbours());
+        } else {
+            update_insertion_cache(tour.do_2opt());
+        }
+    }
+
+    void PALNSSolution::do_or_opt() {
+        if(params && params->local_search.use_or_opt) {
+            update_insertion_cache(tour.do_or_opt(params->local_search.or_opt_max_chain_length));
+        }
+    }
+
+    VertexInsertionPrice PALNSSolution::best_insertion(BoostVertex vertex) {
+        return to_insertion_price(vertex, refresh_cache_entry(free_vertex_index(vertex)).best);
+    }
+
+    std::size_t PALNSSolution::free_vertex_index(BoostVertex vertex) const {
+        const std::size_t index = free_vertex_positions[vertex];
+
+        assert(index < free_vertices.size());
+        assert(free_vertices[index] == vertex);
+        assert(insertion_cache.size() == free_vertices.size());
+
+        return index;
+    }
+
+    void PALNSSolution::push_free_vertex(BoostVertex vertex) {
+        free_vertex_positions[vertex] = static_cast<VertexIndex>(free_vertices.size());
+        free_vertices.push_back(vertex);
+        insertion_cache.push_back(InsertionCacheEntry{});
+    }
+
+    void PALNSSolution::erase_free_vertex(std::size_t index) {
+        assert(index < free_vertices.size());
+
+        const auto last = free_vertices.size() - 1u;
+
+        if(index != last) {
+            free_vertices[index] = free_vertices[last];
+            free_vertex_positions[free_vertices[index]] = static_cast<VertexIndex>(index);
+            insertion_cache[index] = insertion_cache[last];
+        }
+
+        free_vertices.pop_back();
+        insertion_cache.pop_back();
+    }
+
+    bool PALNSSolution::tour_has_edge(VertexIndex v, VertexIndex w) const {
+        if(!tour.visits_vertex(v) || !tour.visits_vertex(w)) { return false; }
+
+        const auto n = tour.vertices.size();
+
+        return tour.vertices[(tour.position_of(v) + 1u) % n] == w ||
+               tour.vertices[(tour.position_of(w) + 1u) % n] == v;
+    }
+
+    CachedInsertion PALNSSolution::price_cached_insertion(BoostVertex vertex, VertexIndex vertex_before, VertexIndex vertex_after) const {
+        const auto increase_in_travel_time = graph->travel_time(vertex_before, vertex) +
+                                             graph->travel_time(vertex, vertex_after) -
+                                             graph->travel_time(vertex_before, vertex_after);
+
+        return {vertex_before, vertex_after, increase_in_travel_time, increase_in_travel_time / graph->prize(vertex)};
+    }
+
+    VertexInsertionPrice PALNSSolution::to_insertion_price(BoostVertex vertex, const CachedInsertion& insertion) const {
+        assert(tour_has_edge(insertion.vertex_before, insertion.vertex_after));
+
+        // Moves such as 2-opt can reverse the edge: travel times are symmetric, so the price is the same.
+        const auto position_before = tour.position_of(insertion.vertex_before);
+        const auto position = (tour.vertices[(position_before + 1u) % tour.vertices.size()] == insertion.vertex_after) ?
+                              position_before :
+                              tour.position_of(insertion.vertex_after);
+
+        return {static_cast<VertexIndex>(vertex), position, insertion.increase_in_travel_time, graph->prize(vertex), insertion.score};
+    }
+
+    bool PALNSSolution::is_known_infeasible(std::size_t index) {
+        const auto& entry = update_cache_entry(index);
+
+        if(!entry.has_best) { return false; }
+
+        // All insertions of a vertex have the same increase in prize, so the best one also has
+        // the smallest increase in travel time (up to the errors of approximate travel times).
+        const auto tolerance = 6.0f * graph->distances.max_error() + 1e-4f * graph->max_travel_time;
+
+        return tour.travel_time + entry.best.increase_in_travel_time - tolerance > graph->max_travel_time;
+    }
+
+    void PALNSSolution::cache_insertions(std::size_t index, const VertexInsertionPrice* insertions, std::size_t n) {
+        auto& entry = insertion_cache[index];
+
+        entry.tour_edges_seen = n_cleared_tour_edges + new_tour_edges.size();
+        entry.has_best = false;
+        entry.has_second_best = false;
+
+        for(auto i = 0u; i < n; ++i) {
+            const auto& insertion = insertions[i];
+            const CachedInsertion cached = {
+                tour.vertices[insertion.position],
+                tour.vertices[(insertion.position + 1u) % tour.vertices.size()],
+                insertion.increase_in_travel_time,
+                insertion.score
+            };
+
+            // A tour with two vertices goes back and forth on the same edge.
+            if(entry.has_best && on_same_edge(cached, entry.best)) { continue; }
+
+            if(!entry.has_best || cached.score < entry.best.score) {
+                if(entry.has_best) {
+                    entry.second_best = entry.best;
+                    entry.has_second_best = true;
+                }
+
+                entry.best = cached;
+                entry.has_best = true;
+            } else if(!entry.has_second_best || cached.score < entry.second_best.score) {
+                entry.second_best = cached;
+                entry.has_second_best = true;
+            }
+        }
+    }
+
+    void PALNSSolution::drop_stale_insertions(InsertionCacheEntry& entry) {
+        if(entry.has_second_best && !tour_has_edge(entry.second_best.vertex_before, entry.second_best.vertex_after)) {
+            entry.has_second_best = false;
+        }
+
+        if(entry.has_best && !tour_has_edge(entry.best.vertex_before, entry.best.vertex_after)) {
+            entry.has_best = entry.has_second_best;
+            entry.best = entry.second_best;
+            entry.has_second_best = false;
+        }
+    }
+
+    InsertionCacheEntry& PALNSSolution::refresh_cache_entry(std::size_t index) {
+        auto& entry = update_cache_entry(index);
+
+        if(!entry.has_best) {
+            std::vector<VertexInsertionPrice> insertions;
+            tour.price_vertex_insertions(free_vertices[index], insertions);
+            cache_insertions(index, insertions.data(), insertions.size());
+        }
+
+        assert(entry.has_best);
+
+        return entry;
+    }
+
+    InsertionCacheEntry& PALNSSolution::update_cache_entry(std::size_t index) {
+        auto& entry = insertion_cache[index];
+        const auto n_tour_edges = n_cleared_tour_edges + new_tour_edges.size();
+
+        if(entry.tour_edges_seen < n_cleared_tour_edges) {
+            // Some of the edges added since the entry was last read are forgotten.
+            entry.has_best = false;
+            entry.has_second_best = false;
+        }
+
+        drop_stale_insertions(entry);
+
+        if(entry.has_best) {
+            const auto vertex = free_vertices[index];
+
+            for(auto i = entry.tour_edges_seen - n_cleared_tour_edges; i < new_tour_edges.size(); ++i) {
+                const auto& edge = new_tour_edges[i];
+
+                // Later edits might have removed the edge.
+                if(!tour_has_edge(edge.first, edge.second)) { continue; }
+
+                const auto insertion = price_cached_insertion(vertex, edge.first, edge.second);
+
+                if(on_same_edge(insertion, entry.best)) { continue; }
+
+                if(insertion.score < entry.best.score) {
+                    entry.second_best = entry.best;
+                    entry.has_second_best = true;
+                    entry.best = insertion;
+                } else if(entry.has_second_best && insertion.score < entry.second_best.score) {
+                    entry.second_best = insertion;
+                }
+            }
+        }
+
+        entry.tour_edges_seen = n_tour_edges;
+
+        return entry;
+    }
+
+    void PALNSSolution::update_insertion_cache(const TourEdgeList& new_edges) {
+        assert(insertion_cache.size() == free_vertices.size());
+
+        // Comparing an entry with more edges than the tour has costs more
+        // than recomputing it: past that, forget the edges instead.
+        if(new_tour_edges.size() + new_edges.size() > tour.vertices.size()) {
+            n_cleared_tour_edges += new_tour_edges.size() + new_edges.size();
+            new_tour_edges.clear();
+        } else {
+            new_tour_edges.insert(new_tour_edges.end(), new_edges.begin(), new_edges.end());
+        }
+    }
+
+    void PALNSSolution::update_insertion_cache(const Tour& old_tour) {
+        TourEdgeList new_edges;
+
+        const auto n = tour.vertices.size();
+        const auto old_n = old_tour.vertices.size();
+
+        for(auto position = 0u; position < n; ++position) {
+            const auto v = tour.vertices[position];
+            const auto w = tour.vertices[(position + 1u) % n];
+
+            if(old_tour.visits_vertex(v) && old_tour.visits_vertex(w)) {
+                const auto old_v = old_tour.position_of(v);
+                const auto old_w = old_tour.position_of(w);
+
+                if((old_v + 1u) % old_n == old_w || (old_w + 1u) % old_n == old_v) { continue; }
+            }
+
+            new_edges.emplace_back(v, w);
+        }
+
+        update_insertion_cache(new_edges);
+    }
+
     bool PALNSSolution::add_vertex_in_best_pos_feasible(BoostVertex vertex) {
-        std::vector<VertexInsertionPrice> insertions;
+        {
+            // Most of the times, the answer comes from the cache.
+            const auto index = free_vertex_index(vertex);
+            const auto entry = refresh_cache_entry(index);
+            const auto best = to_insertion_price(vertex, entry.best);
+
+            if(tour.is_insertion_feasible(best)) {
+                add_vertex(vertex, best.position);
+                return true;
+            }
 
-        for(auto position = 0u; position < tour.vertices.size(); ++position) {
-            insertions.push_back(tour.price_vertex_insertion(vertex, position));
+            if(is_known_infeasible(index)) {
+                return false;
+            }
+
+            if(entry.has_second_best) {
+                const auto second_best = to_insertion_price(vertex, entry.second_best);
+
+                if(tour.is_insertion_feasible(second_best)) {
+                    add_vertex(vertex, second_best.position);
+                    return true;
+                }
+            }
         }
 
+        std::vector<VertexInsertionPrice> insertions;
+
+        tour.price_vertex_insertions(vertex, insertions);
+
         assert(!insertions.empty());
 
         std::sort(
@@ -149,7 +461,7 @@ namespace op {
         );
 
         for(const auto& insertion : insertions) {
-            if(tour.travel_time + insertion.increase_in_travel_time <= graph->max_travel_time) {
+            if(tour.is_insertion_feasible(insertion)) {
                 add_vertex(insertion.vertex, insertion.position);
 
                 assert(free_vertices.size() + tour.vertices.size() == graph->n_reachable_vertices);
@@ -162,6 +474,8 @@ namespace op {
     }
 
     bool PALNSSolution::heur_add_vertex_in_best_pos_feasible(BoostVertex vertex) {
+        if(is_known_infeasible(free_vertex_index(vertex))) { return false; }
+
         std::vector<VertexInsertionPrice> insertions;
 
         find_positions_next_to_neighbours(vertex, insertions);
@@ -181,7 +495,7 @@ namespace op {
         );
 
         for(const auto& insertion : insertions) {
-            if(tour.travel_time + insertion.increase_in_travel_time <= graph->max_travel_time) {
+            if(tour.is_insertion_feasible(insertion)) {
                 add_vertex(insertion.vertex, insertion.position);
 
                 assert(free_vertices.size() + tour.vertices.size() == graph->n_reachable_vertices);
@@ -194,16 +508,7 @@ namespace op {
     }
 
     void PALNSSolution::add_vertex_in_best_pos_any(BoostVertex vertex) {
-        VertexInsertionPrice best_insertion = tour.price_vertex_insertion(vertex, 0u);
-
-        for(auto position = 1u; position < tour.vertices.size(); ++position) {
-            auto i = tour.price_vertex_insertion(vertex, position);
-            if(i.score < best_insertion.score) {
-                best_insertion = i;
-            }
-        }
-
-        add_vertex(best_insertion.vertex, best_insertion.position);
+        add_vertex(vertex, best_insertion(vertex).position);
     }
 
     void PALNSSolution::heur_add_vertex_in_best_pos_any(BoostVertex vertex) {
@@ -230,27 +535,77 @@ namespace op {
         add_vertex(best_insertion.vertex, best_insertion.position);
     }
 
-    std::vector<VertexInsertionPrice> PALNSSolution::all_insertions() const {
+    std::vector<VertexInsertionPrice> PALNSSolution::all_insertions() {
         std::vector<VertexInsertionPrice> insertions;
 
-        for(const auto& vertex : free_vertices) {
-            if(!graph->g[vertex].reachable) { continue; }
-            for(auto position = 0u; position < tour.vertices.size(); ++position) {
-                insertions.push_back(tour.price_vertex_insertion(vertex, position));
+        for(auto i = 0u; i < free_vertices.size(); ++i) {
+            const auto vertex = free_vertices[i];
+
+            if(!graph->is_reachable(vertex)) { continue; }
+
+            const auto first = insertions.size();
+            tour.price_vertex_insertions(vertex, insertions);
+            cache_insertions(i, insertions.data() + first, insertions.size() - first);
+        }
+
+        return insertions;
+    }
+
+    std::vector<VertexInsertionPrice> PALNSSolution::feas_insertions() {
+        std::vector<VertexInsertionPrice> insertions, vertex_insertions;
+
+        for(auto i = 0u; i < free_vertices.size(); ++i) {
+            const auto vertex = free_vertices[i];
+
+            if(!graph->is_reachable(vertex)) { continue; }
+            if(is_known_infeasible(i)) { continue; }
+
+            vertex_insertions.clear();
+            tour.price_vertex_insertions(vertex, vertex_insertions);
+            cache_insertions(i, vertex_insertions.data(), vertex_insertions.size());
+
+            for(const auto& insertion : vertex_insertions) {
+                if(tour.is_insertion_feasible(insertion)) {
+                    insertions.push_back(insertion);
+                }
             }
         }
 
         return insertions;
     }
 
-    std::vector<VertexInsertionPrice> PALNSSolution::feas_insertions() const {
-        std::vector<VertexInsertionPrice> insertions;
+    std::vector<VertexInsertionPrice> PALNSSolution::best_feas_insertions() {
+        std::vector<VertexInsertionPrice> insertions, vertex_insertions;
 
-        for(const auto& vertex : free_vertices) {
-            if(!graph->g[vertex].reachable) { continue; }
-            for(auto position = 0u; position < tour.vertices.size(); ++position) {
-                const auto insertion = tour.price_vertex_insertion(vertex, position);
-                if(insertion.increase_in_travel_time + tour.travel_time <= graph->max_travel_time) {
+        for(auto i = 0u; i < free_vertices.size(); ++i) {
+            const auto vertex = free_vertices[i];
+
+            if(!graph->is_reachable(vertex)) { continue; }
+            if(is_known_infeasible(i)) { continue; }
+
+            const auto& entry = refresh_cache_entry(i);
+            const auto best = to_insertion_price(vertex, entry.best);
+
+            if(tour.is_insertion_feasible(best)) {
+                insertions.push_back(best);
+
+                if(entry.has_second_best) {
+                    const auto second_best = to_insertion_price(vertex, entry.second_best);
+
+                    if(tour.is_insertion_feasible(second_best)) {
+                        insertions.push_back(second_best);
+                    }
+                }
+
+                continue;
+            }
+
+            // With approximate travel times, other insertions can be feasible even if the best one is not.
+            vertex_insertions.clear();
+            tour.price_vertex_insertions(vertex, vertex_insertions);
+
+            for(const auto& insertion : vertex_insertions) {
+                if(tour.is_insertion_feasible(insertion)) {
                     insertions.push_back(insertion);
                 }
             }
@@ -263,7 +618,7 @@ namespace op {
         std::vector<VertexInsertionPrice> insertions;
 
         for(const auto& vertex : free_vertices) {
-            if(!graph->g[vertex].reachable) { continue; }
+            if(!graph->is_reachable(vertex)) { continue; }
 
             find_positions_next_to_neighbours(vertex, insertions);
 
@@ -277,11 +632,14 @@ namespace op {
         return insertions;
     }
 
-    std::vector<VertexInsertionPrice> PALNSSolution::heur_feas_insertions() const {
+    std::vector<VertexInsertionPrice> PALNSSolution::heur_feas_insertions() {
         std::vector<VertexInsertionPrice> insertions;
 
-        for(const auto& vertex : free_vertices) {
-            if(!graph->g[vertex].reachable) { continue; }
+        for(auto i = 0u; i < free_vertices.size(); ++i) {
+            const auto vertex = free_vertices[i];
+
+            if(!graph->is_reachable(vertex)) { continue; }
+            if(is_known_infeasible(i)) { continue; }
 
             find_feas_positions_next_to_neighbours(vertex, insertions);
 
@@ -294,10 +652,8 @@ namespace op {
     }
 
     void PALNSSolution::find_positions_next_to_neighbour(BoostVertex vertex, BoostVertex neighbour, std::vector<VertexInsertionPrice>& insertions) const {
-        const auto nvertex_it = std::find(tour.vertices.begin(), tour.vertices.end(), neighbour);
-
-        if(nvertex_it != tour.vertices.end()) {
-            const auto position = nvertex_it - tour.vertices.begin();
+        if(tour.visits_vertex(neighbour)) {
+            const auto position = tour.position_of(neighbour);
 
             assert(position >= 1u);
 
@@ -307,42 +663,55 @@ namespace op {
     }
 
     void PALNSSolution::find_feas_positions_next_to_neighbour(BoostVertex vertex, BoostVertex neighbour, std::vector<VertexInsertionPrice>& insertions) const {
-        const auto nvertex_it = std::find(tour.vertices.begin(), tour.vertices.end(), neighbour);
-
-        if(nvertex_it != tour.vertices.end()) {
-            const auto position = nvertex_it - tour.vertices.begin();
+        if(tour.visits_vertex(neighbour)) {
+            const auto position = tour.position_of(neighbour);
 
             assert(position >= 1u);
 
             const auto ins1 = tour.price_vertex_insertion(vertex, position - 1);
             const auto ins2 = tour.price_vertex_insertion(vertex, position);
 
-            if(ins1.increase_in_travel_time + tour.travel_time <= graph->max_travel_time) {
+            if(tour.is_insertion_feasible(ins1)) {
                 insertions.push_back(ins1);
             }
 
-            if(ins2.increase_in_travel_time + tour.travel_time <= graph->max_travel_time) {
+            if(tour.is_insertion_feasible(ins2)) {
                 insertions.push_back(ins2);
             }
         }
     }
 
     void PALNSSolution::find_positions_next_to_neighbours(BoostVertex vertex, std::vector<VertexInsertionPrice>& insertions) const {
-        for(const auto& nvertex : graph->proximity_map.at(vertex)) {
+        for(const auto& nvertex : graph->proximity_map[vertex]) {
             find_positions_next_to_neighbour(vertex, nvertex.vertex, insertions);
         }
     }
 
     void PALNSSolution::find_feas_positions_next_to_neighbours(BoostVertex vertex, std::vector<VertexInsertionPrice>& insertions) const {
-        for(const auto& nvertex : graph->proximity_map.at(vertex)) {
+        for(const auto& nvertex : graph->proximity_map[vertex]) {
             find_feas_positions_next_to_neighbour(vertex, nvertex.vertex, insertions);
         }
     }
 
     void PALNSSolution::generic_find_positions_next_to_nearby_vertices(BoostVertex vertex, std::vector<VertexInsertionPrice>& insertions, bool feasible) const {
-        assert(!graph->proximity_map.at(vertex).empty());
+        if(graph->proximity_map[vertex].empty()) {
+            // There are no nearby vertices to start the search from: either the
+            // proximity map was built without neighbours or, with pruned edges,
+            // the only neighbour of the vertex is the depot (which is not in the
+            // proximity map). Fall back to pricing every position.
+            std::vector<VertexInsertionPrice> all_insertions;
+            tour.price_vertex_insertions(vertex, all_insertions);
+
+            for(const auto& insertion : all_insertions) {
+                if(!feasible || tour.is_insertion_feasible(insertion)) {
+                    insertions.push_back(insertion);
+                }
+            }
+
+            return;
+        }
 
-        auto min_r = graph->proximity_map.at(vertex).back().travel_time;
+        auto min_r = graph->proximity_map[vertex].back().travel_time;
         auto max_r = min_r * 1.1f;
 
         // Compensate for the imprecisions in not EUC_2D instances:
@@ -351,7 +720,7 @@ namespace op {
         // insertions). In this case, instead of starting with a
         // donut, in the first iteration we basically start with a
         // full circle.
-        if(graph->opi->get_raw_specification<std::string>("EDGE_WEIGHT_TYPE") != "EUC_2D") {
+        if(graph->distances.metric != DistanceMetric::Euc2D && graph->distances.metric != DistanceMetric::Euclidean) {
             min_r = 0.1f;
         }
 
@@ -365,7 +734,7 @@ namespace op {
         std::size_t times_failed = 0u;
 
         while(true) {
-            const auto points = within_radii(centre, min_r, max_r, graph->rtree);
+            const auto points = within_radii(centre, min_r, max_r, graph->spatial_index);
 
             if(!points.empty()) {
                 for(const auto& point : points) {
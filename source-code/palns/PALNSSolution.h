@@ -13,6 +13,45 @@
 #include "../Tour.h"
 
 namespace op {
+    /**
+     * Insertion of a free vertex on an edge of the tour, identified by its
+     * endpoints rather than by a position, so that it stays meaningful while
+     * other parts of the tour change.
+     */
+    struct CachedInsertion {
+        VertexIndex vertex_before;
+        VertexIndex vertex_after;
+        float increase_in_travel_time;
+        float score;
+    };
+
+    /**
+     * Best and second-best insertions of a free vertex, by score. If has_best
+     * is set, best is the best insertion on any edge of the tour, as it was
+     * when the first tour_edges_seen edges were added to it (see
+     * PALNSSolution::new_tour_edges). If, also, has_second_best is set,
+     * second_best is the best insertion on any other edge. Otherwise they
+     * are unknown.
+     */
+    struct InsertionCacheEntry {
+        CachedInsertion best;
+        CachedInsertion second_best;
+        std::size_t tour_edges_seen;
+        bool has_best;
+        bool has_second_best;
+    };
+
+    /**
+     * Number of insertion cache entries stored inline. The cache is copied
+     * along with the solution, so it only gets a small inline storage.
+     */
+    constexpr std::size_t insertion_cache_capacity = 16u;
+
+    /**
+     * Insertion cache entries.
+     */
+    using InsertionCacheList = boost::container::small_vector<InsertionCacheEntry, insertion_cache_capacity>;
+
     struct PALNSSolution {
         /**
          * The underlying graph.
@@ -31,9 +70,43 @@ namespace op {
 
         /**
          * Free vertices: reachable vertices not included
-         * in the tour.
+         * in the tour, in no particular order. Only edit it
+         * through this class, which keeps free_vertex_positions
+         * and insertion_cache aligned with it.
+         */
+        SmallVertexList free_vertices;
+
+        /**
+         * Position of each free vertex in free_vertices. The
+         * positions of the other vertices are meaningless.
+         */
+        SmallVertexList free_vertex_positions;
+
+        /**
+         * Best insertions of the free vertices: entry i refers to
+         * free_vertices[i]. Entries are computed when first needed, and
+         * brought up to date when read: entries on edges which are no longer
+         * in the tour fall back to their second-best insertion (or are
+         * recomputed), and the others are compared with the insertions on
+         * the edges added to the tour since they were last read (see
+         * new_tour_edges). Methods which read the cache also fill it in,
+         * and therefore are not const.
+         */
+        InsertionCacheList insertion_cache;
+
+        /**
+         * Edges added to the tour by the edits made through this class,
+         * in order. When it would grow longer than the tour, the list is
+         * cleared, and the entries which did not see its edges are
+         * recomputed when next read.
          */
-        std::vector<BoostVertex> free_vertices;
+        TourEdgeList new_tour_edges;
+
+        /**
+         * Number of edges cleared from new_tour_edges. Edge i of new_tour_edges
+         * is the (n_cleared_tour_edges + i)-th edge added to the tour.
+         */
+        std::size_t n_cleared_tour_edges = 0u;
 
         /** Default constructor.
          */
@@ -78,6 +151,24 @@ namespace op {
          */
         bool remove_vertex_if_present(BoostVertex vertex);
 
+        /**
+         * Removes the vertices in a range of positions from the solution
+         * tour, in a single pass (see Tour::remove_segment).
+         *
+         * @param first     Position of the first vertex to remove.
+         * @param last      One past the position of the last vertex to remove.
+         */
+        void remove_segment(std::size_t first, std::size_t last);
+
+        /**
+         * Removes a set of vertices from the solution tour, in a single
+         * pass (see Tour::remove_vertices).
+         *
+         * @param to_remove     Pointer to the first vertex to remove.
+         * @param n             Number of vertices to remove.
+         */
+        void remove_vertices(const VertexIndex* to_remove, std::size_t n);
+
         /**
          * Adds a vertex to the solution tour, in the specified position.
          *
@@ -86,6 +177,24 @@ namespace op {
          */
         void add_vertex(BoostVertex vertex, std::size_t position);
 
+        /**
+         * Replaces the solution tour, e.g. after editing a copy of it,
+         * updating the free vertices and the insertion cache.
+         *
+         * @param new_tour  The new tour.
+         */
+        void set_tour(Tour new_tour);
+
+        /**
+         * Gives the best insertion of a free vertex (i.e. the one with the
+         * best score, not necessarily feasible), priced on the current tour.
+         * It is read from the insertion cache, when possible.
+         *
+         * @param vertex    The vertex.
+         * @return          The best insertion.
+         */
+        VertexInsertionPrice best_insertion(BoostVertex vertex);
+
         /**
          * Adds a vertex to the solution tour, in the best possible
          * position (i.e. the position which has the best insertion
@@ -124,11 +233,11 @@ namespace op {
 
         /**
          * Returns a list of all possible insertions of all free
-         * vertices.
+         * vertices. It also fills in the insertion cache.
          *
          * @return  The list of insertions.
          */
-        std::vector<VertexInsertionPrice> all_insertions() const;
+        std::vector<VertexInsertionPrice> all_insertions();
 
         /**
          * Returns a subset of all possible insertions, for all free
@@ -141,20 +250,32 @@ namespace op {
 
         /**
         * Returns a list of all feasible insertions of all free
-        * vertices.
+        * vertices. It also fills in the insertion cache.
         *
         * @return  The list of insertions.
         */
-        std::vector<VertexInsertionPrice> feas_insertions() const;
+        std::vector<VertexInsertionPrice> feas_insertions();
+
+        /**
+         * Returns the best feasible insertions of each free vertex, which
+         * are its best and second-best insertions in the insertion cache,
+         * when they are feasible, or all its feasible insertions otherwise.
+         * Vertices which the insertion cache shows cannot be inserted are
+         * skipped.
+         *
+         * @return  The list of insertions.
+         */
+        std::vector<VertexInsertionPrice> best_feas_insertions();
 
         /**
          * Returns a subset of all feasible insertions, for all free
          * vertices. The subset is determined heuristically and is
-         * supposed to contain "good" insertions.
+         * supposed to contain "good" insertions. Vertices which the
+         * insertion cache shows cannot be inserted are skipped.
          *
          * @return  The list of insertions.
          */
-        std::vector<VertexInsertionPrice> heur_feas_insertions() const;
+        std::vector<VertexInsertionPrice> heur_feas_insertions();
 
         /**
          * Removes enough vertices from the tour to make
@@ -162,8 +283,96 @@ namespace op {
          */
         void make_travel_time_feasible();
 
+        /**
+         * Shortens the tour with 2-opt. Long tours (see
+         * LocalSearchParams::neighbour_2opt_min_size) use the
+         * neighbour-list variant, Tour::do_2opt_neighbours().
+         */
+        void do_2opt();
+
+        /**
+         * Shortens the tour with Or-opt, if enabled in the local search
+         * params (see LocalSearchParams::use_or_opt).
+         */
+        void do_or_opt();
+
     private:
 
+        /**
+         * Gives the index of a free vertex in free_vertices (and insertion_cache),
+         * in O(1) time.
+         */
+        std::size_t free_vertex_index(BoostVertex vertex) const;
+
+        /**
+         * Appends a vertex to the free vertices, with an unknown cache entry.
+         */
+        void push_free_vertex(BoostVertex vertex);
+
+        /**
+         * Removes the free vertex at an index, and its cache entry, in O(1)
+         * time: the last free vertex takes its place.
+         */
+        void erase_free_vertex(std::size_t index);
+
+        /**
+         * Tells whether two vertices are consecutive in the tour, in either order.
+         */
+        bool tour_has_edge(VertexIndex v, VertexIndex w) const;
+
+        /**
+         * Prices the insertion of a vertex on an edge of the tour, for the insertion cache.
+         */
+        CachedInsertion price_cached_insertion(BoostVertex vertex, VertexIndex vertex_before, VertexIndex vertex_after) const;
+
+        /**
+         * Converts a cached insertion, which must be on an edge of the tour,
+         * to the insertion at the corresponding position.
+         */
+        VertexInsertionPrice to_insertion_price(BoostVertex vertex, const CachedInsertion& insertion) const;
+
+        /**
+         * Tells whether the insertion cache shows that the free vertex at an
+         * index cannot be inserted without exceeding the maximum travel time.
+         * False means that it is unknown.
+         */
+        bool is_known_infeasible(std::size_t index);
+
+        /**
+         * Replaces the cache entry of the free vertex at an index, with the
+         * best two insertions among all its insertions, priced on the tour.
+         */
+        void cache_insertions(std::size_t index, const VertexInsertionPrice* insertions, std::size_t n);
+
+        /**
+         * Gives the cache entry of the free vertex at an index, computing its
+         * best insertion if it is not known.
+         */
+        InsertionCacheEntry& refresh_cache_entry(std::size_t index);
+
+        /**
+         * Brings the cache entry of the free vertex at an index up to date with
+         * the tour, without computing its best insertion if it is not known.
+         */
+        InsertionCacheEntry& update_cache_entry(std::size_t index);
+
+        /**
+         * Drops the insertions of a cache entry whose edge is no longer in the tour.
+         */
+        void drop_stale_insertions(InsertionCacheEntry& entry);
+
+        /**
+         * Records the edges added to the tour by an edit, for the cache entries
+         * to be compared with them when next read.
+         */
+        void update_insertion_cache(const TourEdgeList& new_edges);
+
+        /**
+         * Records the edges added to the tour when it was replaced, comparing the
+         * edges of the new tour with those of the old one.
+         */
+        void update_insertion_cache(const Tour& old_tour);
+
         void find_positions_next_to_neighbour(BoostVertex vertex, BoostVertex neighbour, std::vector<VertexInsertionPrice>& insertions) const;
         void find_positions_next_to_neighbours(BoostVertex vertex, std::vector<VertexInsertionPrice>& insertions) const;
         void find_positions_next_to_nearby_vertices(BoostVertex vertex, std::vector<VertexInsertionPrice>& insertions) const;
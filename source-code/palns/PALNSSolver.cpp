@@ -42,16 +42,16 @@ namespace op {
     Tour PALNSSolver::solve(std::unique_ptr<Tour>& initial_sol) {
         using namespace std::chrono;
 
-        const auto vertex_shuffle = [] (std::vector<BoostVertex>& vertices, std::mt19937& mt) -> void {
+        const auto vertex_shuffle = [] (SmallVertexList& vertices, std::mt19937& mt) -> void {
             std::shuffle(vertices.begin(), vertices.end(), mt);
         };
 
-        const auto vertex_by_prize = [this] (std::vector<BoostVertex>& vertices, std::mt19937&) -> void {
+        const auto vertex_by_prize = [this] (SmallVertexList& vertices, std::mt19937&) -> void {
             std::sort(
                 vertices.begin(),
                 vertices.end(),
                 [this] (BoostVertex v1, BoostVertex v2) -> bool {
-                    return graph.g[v1].prize > graph.g[v2].prize;
+                    return graph.prize(v1) > graph.prize(v2);
                 }
             );
         };
@@ -64,7 +64,7 @@ namespace op {
             initial = *initial_sol;
         } else {
             const GreedyHeuristic gh(graph, palns_problem_params);
-            initial = gh.solve();
+            initial = gh.solve(mt);
         }
 
         const PALNSSolution palns_initial(initial, &palns_problem_params);
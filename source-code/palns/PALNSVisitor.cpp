@@ -2,7 +2,6 @@
 // Created by alberto on 12/11/17.
 //
 
-#include <thread>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/interprocess/sync/file_lock.hpp>
@@ -23,18 +22,15 @@ namespace op {
 
             if(problem_params.local_search.use_2opt) {
                 assert(!problem_params.local_search.use_tsp);
-                alg_status.best_solution.tour.do_2opt();
+                alg_status.best_solution.do_2opt();
             }
 
             if(problem_params.local_search.use_tsp) {
                 assert(!problem_params.local_search.use_2opt);
-                std::stringstream ss;
-                ss << std::this_thread::get_id();
-
                 Tour t = run_lin_kernighan(
                     *alg_status.best_solution.graph,
-                    alg_status.best_solution.tour.vertices,
-                    ss.str()
+                    VertexList(alg_status.best_solution.tour.vertices.begin(), alg_status.best_solution.tour.vertices.end()),
+                    problem_params.local_search.tsp_options(mt())
                 );
 
                 if(t.travel_time < alg_status.best_solution.tour.travel_time) {
@@ -45,6 +41,8 @@ namespace op {
                 }
             }
 
+            alg_status.best_solution.do_or_opt();
+
             if(problem_params.local_search.fill_tour) {
                 GreedyRepair gr(&problem_params);
                 gr.repair_solution(alg_status.best_solution, mt);
@@ -70,39 +70,45 @@ namespace op {
             auto cluster_id = ci_dist(mt);
             const auto& cluster = clustering->clusters[cluster_id];
 
+            // Vertices to remove, all at once at the end.
+            SmallVertexList to_remove;
+
+            // Check it we haven't already removed almost all
+            // vertices from the tour!
+            const auto tour_almost_empty = [&] () -> bool {
+                return sol.tour.vertices.size() - to_remove.size() == 2u;
+            };
+
             if(cluster.size() <= params->destroy.max_n_of_vertices_to_remove) {
                 // Cluster small enough:
                 for(const auto& vertex : cluster) {
-                    // Check it we haven't already removed almost all
-                    // vertices from the tour!
-                    if(sol.tour.vertices.size() == 2u) { break; }
+                    if(tour_almost_empty()) { break; }
 
-                    sol.remove_vertex_if_present(vertex);
+                    if(sol.tour.visits_vertex(vertex)) {
+                        to_remove.push_back(vertex);
+                    }
                 }
             } else {
                 // Cluster potentially too big:
                 auto cluster_cpy = cluster;
                 std::shuffle(cluster_cpy.begin(), cluster_cpy.end(), mt);
-                auto removed_v = 0u;
 
                 do {
-                    // Check it we haven't already removed almost all
-                    // vertices from the tour!
-                    if(sol.tour.vertices.size() == 2u) { break; }
+                    if(tour_almost_empty()) { break; }
 
                     auto vertex = cluster_cpy.back();
                     cluster_cpy.pop_back();
 
-                    const bool removed = sol.remove_vertex_if_present(vertex);
-                    
-                    if(removed) {
-                        ++removed_v;
+                    if(sol.tour.visits_vertex(vertex)) {
+                        to_remove.push_back(vertex);
                     }
                 } while(
                     !cluster_cpy.empty() &&
-                    removed_v <= params->destroy.max_n_of_vertices_to_remove
+                    to_remove.size() <= params->destroy.max_n_of_vertices_to_remove
                 );
             }
+
+            sol.remove_vertices(to_remove.data(), to_remove.size());
         }
     };
 }
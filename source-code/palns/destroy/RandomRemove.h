@@ -5,6 +5,8 @@
 #ifndef OP_RANDOMREMOVE_H
 #define OP_RANDOMREMOVE_H
 
+#include <algorithm>
+#include <iterator>
 #include <palns/DestroyMethod.h>
 #include <as/random.h>
 #include "../PALNSProblemParams.h"
@@ -72,8 +74,6 @@ namespace op {
          * @param mt    A random number generator.
          */
         void destroy_solution(PALNSSolution& sol, std::mt19937& mt) override {
-            using as::rnd::sample;
-
             if(sol.tour.vertices.empty()) { return; }
 
             assert(params);
@@ -90,15 +90,18 @@ namespace op {
             n_vertices_to_remove = std::min(n_vertices_to_remove, params->destroy.max_n_of_vertices_to_remove);
 
             // The removable vertices are all, but the depot.
-            std::vector<BoostVertex> removable_vertices = sol.tour.vertices;
-            assert(removable_vertices.front() == 0u);
-            removable_vertices.erase(removable_vertices.begin());
-
-            auto vertices_to_remove = sample(removable_vertices, n_vertices_to_remove, mt);
+            assert(sol.tour.vertices.front() == 0u);
+
+            SmallVertexList vertices_to_remove;
+            std::sample(
+                sol.tour.vertices.begin() + 1,
+                sol.tour.vertices.end(),
+                std::back_inserter(vertices_to_remove),
+                n_vertices_to_remove,
+                mt
+            );
 
-            for(const auto& vertex : vertices_to_remove) {
-                sol.remove_vertex(vertex);
-            }
+            sol.remove_vertices(vertices_to_remove.data(), vertices_to_remove.size());
         }
     };
 }
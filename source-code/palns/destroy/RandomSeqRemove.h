@@ -63,23 +63,16 @@ namespace op {
             if(n_vertices_to_remove < 1u) { return; }
 
             std::uniform_int_distribution<std::size_t> pv_dist(1u, vertices.size() - 1);
-            auto current_pivot = pv_dist(mt);
+            const auto pivot = pv_dist(mt);
 
-            std::vector<BoostVertex> vertices_to_remove;
-            for(auto i = 0u; i < n_vertices_to_remove; ++i) {
-                if(current_pivot == 0u) {
-                    ++current_pivot; // Skip the depot
-                }
+            // The sequence starts at the pivot and, if it reaches the end
+            // of the tour, continues after the depot. Remove the part at the
+            // end first, so that the positions of the other part stay valid.
+            const auto n_vertices_at_end = std::min(n_vertices_to_remove, vertices.size() - pivot);
+            const auto n_vertices_at_start = n_vertices_to_remove - n_vertices_at_end;
 
-                vertices_to_remove.push_back(vertices[current_pivot]);
-
-                ++current_pivot;
-                current_pivot = current_pivot % vertices.size();
-            }
-
-            for(const auto& vertex : vertices_to_remove) {
-                sol.remove_vertex(vertex);
-            }
+            sol.remove_segment(pivot, pivot + n_vertices_at_end);
+            sol.remove_segment(1u, 1u + n_vertices_at_start);
         }
     };
 }
@@ -8,6 +8,7 @@
 #include <palns/RepairMethod.h>
 #include "../PALNSSolution.h"
 #include "../PALNSProblemParams.h"
+#include "../../LinkedTour.h"
 
 namespace op {
     struct GreedyInsertionTabuItem {
@@ -18,13 +19,14 @@ namespace op {
         GreedyInsertionTabuItem(BoostVertex v1, BoostVertex v2, std::uint32_t expire) :
                 v1{v1}, v2{v2}, expire{expire} {}
 
-        bool is_compatible(const VertexInsertionPrice& insertion, const PALNSSolution& solution) const {
-            if(v1 == solution.tour.vertices[insertion.position] &&
+        template<typename InsertionType, typename TourType>
+        bool is_compatible(const InsertionType& insertion, const TourType& tour) const {
+            if(v1 == tour.vertex_before(insertion) &&
                v2 == insertion.vertex) { return false; }
 
             return !(
                 v1 == insertion.vertex &&
-                v2 == solution.tour.vertices[(insertion.position + 1) % solution.tour.vertices.size()]
+                v2 == tour.vertex_after(insertion)
             );
         }
     };
@@ -87,17 +89,71 @@ namespace op {
             );
             // --- End tabu part ---
 
-            auto insertions = params->repair.heuristic ?
-                solution.heur_feas_insertions() :
-                solution.feas_insertions();
+            // Without the heuristic, start from the best two insertions of each vertex, which the
+            // insertion cache mostly provides, rather than pricing every insertion: other insertions
+            // of a vertex are only priced if those positions are taken by other vertices.
+            const bool best_only = !params->repair.heuristic;
+
+            auto insertions = best_only ?
+                solution.best_feas_insertions() :
+                solution.heur_feas_insertions();
 
             if(insertions.empty()) { return; }
 
-            while(true) {
-                if(insertions.empty()) {
-                    break;
+            if(solution.tour.vertices.size() < params->repair.linked_tour_min_size) {
+                insert_greedily(solution.tour, std::move(insertions), solution.free_vertices.size(), best_only,
+                    [&solution] (const VertexInsertionPrice& insertion) {
+                        solution.add_vertex(insertion.vertex, insertion.position);
+                    }
+                );
+                return;
+            }
+
+            // On long tours, work on a linked representation of the tour. Adding a vertex
+            // does not shift the following vertices, so the insertions which are still valid
+            // need not be updated, and each addition takes O(1) time.
+            LinkedTour tour{solution.tour};
+
+            std::vector<LinkedInsertionPrice> linked_insertions;
+            linked_insertions.reserve(insertions.size());
+
+            for(const auto& insertion : insertions) {
+                linked_insertions.push_back(LinkedTour::translate_insertion(solution.tour, insertion));
+            }
+
+            insert_greedily(tour, std::move(linked_insertions), solution.free_vertices.size(), best_only,
+                [&tour] (const LinkedInsertionPrice& insertion) {
+                    tour.add_vertex(insertion.vertex, insertion.vertex_before);
                 }
+            );
+
+            solution.set_tour(tour.to_tour());
+
+            assert(solution.free_vertices.size() + solution.tour.vertices.size() == solution.graph->n_reachable_vertices);
+        }
+
+    private:
 
+        /**
+         * Main loop of repair_solution(): repeatedly performs the best
+         * insertion which is not tabu, until none is left.
+         *
+         * @tparam TourType         Tour or LinkedTour.
+         * @tparam InsertionType    VertexInsertionPrice or LinkedInsertionPrice, matching TourType.
+         * @tparam AddVertexFn      Type of the function adding a vertex.
+         * @param tour              The tour the insertions are priced on.
+         * @param insertions        The feasible insertions.
+         * @param n_free_vertices   Number of vertices not in the tour.
+         * @param best_only         Whether the insertions of each vertex are only its best ones,
+         *                          so that a vertex losing all of them to the position of another
+         *                          insertion must be priced again on the whole tour.
+         * @param add_vertex        Function which performs an insertion on the tour.
+         */
+        template<typename TourType, typename InsertionType, typename AddVertexFn>
+        void insert_greedily(const TourType& tour, std::vector<InsertionType> insertions, std::size_t n_free_vertices, bool best_only, AddVertexFn&& add_vertex) {
+            std::vector<InsertionType> vertex_insertions;
+
+            while(!insertions.empty()) {
                 std::sort(
                     insertions.begin(),
                     insertions.end(),
@@ -109,7 +165,7 @@ namespace op {
                 // --- Temporary: trying tabu moves ---
                 auto candidate_insertion_it = insertions.begin();
                 while(  candidate_insertion_it != insertions.end() &&
-                        !std::all_of(tabu.begin(), tabu.end(), [&] (const auto& t) { return t.is_compatible(*candidate_insertion_it, solution); }))
+                        !std::all_of(tabu.begin(), tabu.end(), [&] (const auto& t) { return t.is_compatible(*candidate_insertion_it, tour); }))
                 {
                     ++candidate_insertion_it;
                 }
@@ -118,15 +174,15 @@ namespace op {
 
                 // I need this copy because the insertion gets erased from the list
                 // quite early in the following, but I keep referencing it until later.
-                auto candidate_insertion = *candidate_insertion_it;
+                const auto candidate_insertion = *candidate_insertion_it;
 
                 // --- Temporary: trying tabu moves ---
-                tabu.emplace_back(solution.tour.vertices[candidate_insertion.position], candidate_insertion.vertex, n_called + 10000);
-                tabu.emplace_back(candidate_insertion.vertex, solution.tour.vertices[(candidate_insertion.position + 1) % (solution.tour.vertices.size())], n_called + 10000);
+                tabu.emplace_back(tour.vertex_before(candidate_insertion), candidate_insertion.vertex, n_called + 10000);
+                tabu.emplace_back(candidate_insertion.vertex, tour.vertex_after(candidate_insertion), n_called + 10000);
                 // --- End tabu part
 
-                assert(solution.tour.travel_time + candidate_insertion.increase_in_travel_time <= solution.graph->max_travel_time);
-                solution.add_vertex(candidate_insertion.vertex, candidate_insertion.position);
+                assert(tour.is_insertion_feasible(candidate_insertion));
+                add_vertex(candidate_insertion);
 
                 // Remove all other insertions for the inserted vertex.
                 // Remove all other insertions for the same position.
@@ -135,20 +191,29 @@ namespace op {
 
                 // Vertices which can potentially be added later in this position:
                 std::unordered_set<BoostVertex> can_add;
-                can_add.reserve(solution.free_vertices.size());
+                can_add.reserve(n_free_vertices);
 
-                auto insertion_visitor = [&candidate_insertion, &can_add, &solution] (auto& insertion) -> bool {
-                    if(insertion.vertex == candidate_insertion.vertex ||
-                        solution.tour.travel_time + insertion.increase_in_travel_time > solution.graph->max_travel_time ||
-                        insertion.position == candidate_insertion.position
-                    ) {
+                // Vertices which had an insertion in the position just taken:
+                std::unordered_set<BoostVertex> displaced;
+
+                auto insertion_visitor = [&candidate_insertion, &can_add, &displaced, &tour] (auto& insertion) -> bool {
+                    if(insertion.vertex == candidate_insertion.vertex) {
                         return true;
                     }
 
-                    // At the same time, increase by one the position of all
-                    // insertions following the current one.
-                    if(insertion.position > candidate_insertion.position) {
-                        ++insertion.position;
+                    if(insertion_point(insertion) == insertion_point(candidate_insertion)) {
+                        displaced.insert(insertion.vertex);
+                        return true;
+                    }
+
+                    // At the same time, update the position of all insertions
+                    // following the current one, if the tour type needs it.
+                    // (We do this before checking feasibility, as the check
+                    // might need to look up the insertion's position.)
+                    shift_position(insertion, candidate_insertion);
+
+                    if(!tour.is_insertion_feasible(insertion)) {
+                        return true;
                     }
 
                     can_add.insert(insertion.vertex);
@@ -161,19 +226,78 @@ namespace op {
                     insertions.erase(std::remove_if(insertions.begin(), insertions.end(), insertion_visitor), insertions.end());
                 }
 
-                // Recompute all insertions for the chosen position and the following one.
+                // Recompute all insertions on the two new edges.
                 for(const auto& vertex : can_add) {
-                    const auto ins1 = solution.tour.price_vertex_insertion(vertex, candidate_insertion.position);
-                    if(solution.tour.travel_time + ins1.increase_in_travel_time <= solution.graph->max_travel_time) {
+                    const auto ins1 = tour.price_vertex_insertion(vertex, insertion_point(candidate_insertion));
+                    if(tour.is_insertion_feasible(ins1)) {
                         insertions.push_back(ins1);
                     }
-                    const auto ins2 = solution.tour.price_vertex_insertion(vertex, candidate_insertion.position + 1u);
-                    if(solution.tour.travel_time + ins2.increase_in_travel_time <= solution.graph->max_travel_time) {
+                    const auto ins2 = tour.price_vertex_insertion(vertex, insertion_point_after(candidate_insertion));
+                    if(tour.is_insertion_feasible(ins2)) {
                         insertions.push_back(ins2);
                     }
                 }
+
+                if(!best_only) { continue; }
+
+                // Price again the vertices which lost all their insertions to the position just taken.
+                for(const auto& vertex : displaced) {
+                    if(can_add.count(vertex) > 0u) { continue; }
+
+                    vertex_insertions.clear();
+                    tour.price_vertex_insertions(vertex, vertex_insertions);
+
+                    for(const auto& insertion : vertex_insertions) {
+                        if(tour.is_insertion_feasible(insertion)) {
+                            insertions.push_back(insertion);
+                        }
+                    }
+                }
             }
         }
+
+        /**
+         * Position of a Tour insertion, as passed to Tour::price_vertex_insertion().
+         */
+        static std::size_t insertion_point(const VertexInsertionPrice& insertion) {
+            return insertion.position;
+        }
+
+        /**
+         * Vertex preceding a LinkedTour insertion, as passed to LinkedTour::price_vertex_insertion().
+         */
+        static BoostVertex insertion_point(const LinkedInsertionPrice& insertion) {
+            return insertion.vertex_before;
+        }
+
+        /**
+         * Position of the insertions just after the vertex just inserted.
+         */
+        static std::size_t insertion_point_after(const VertexInsertionPrice& inserted) {
+            return inserted.position + 1u;
+        }
+
+        /**
+         * In a linked tour, insertions just after a vertex are identified by that vertex.
+         */
+        static BoostVertex insertion_point_after(const LinkedInsertionPrice& inserted) {
+            return inserted.vertex;
+        }
+
+        /**
+         * Increases by one the position of an insertion following the vertex
+         * just inserted, as the vertices after it are shifted forward.
+         */
+        static void shift_position(VertexInsertionPrice& insertion, const VertexInsertionPrice& inserted) {
+            if(insertion.position > inserted.position) {
+                ++insertion.position;
+            }
+        }
+
+        /**
+         * In a linked tour, the vertices preceding the insertions do not change.
+         */
+        static void shift_position(LinkedInsertionPrice&, const LinkedInsertionPrice&) {}
     };
 }
 
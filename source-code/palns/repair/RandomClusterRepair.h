@@ -61,7 +61,7 @@ namespace op {
 
             for(const auto& vertex : cluster) {
                 if(solution.tour.visits_vertex(vertex)) { continue; }
-                if(!solution.graph->g[vertex].reachable) { continue; }
+                if(!solution.graph->is_reachable(vertex)) { continue; }
 
                 assert(!solution.graph->g[vertex].depot);
                 assert(contains(solution.free_vertices, vertex));
@@ -82,7 +82,7 @@ namespace op {
             }
 
             if(params->repair.intermediate_infeasible && params->repair.use_2opt_before_restoring_feasibility) {
-                solution.tour.do_2opt();
+                solution.do_2opt();
             }
 
             solution.make_travel_time_feasible();
@@ -10,7 +10,7 @@
 
 namespace op {
     struct SeqVertexRepair : public mlpalns::RepairMethod<PALNSSolution> {
-        using VertexSorter = std::function<void(std::vector<BoostVertex>&, std::mt19937&)>;
+        using VertexSorter = std::function<void(SmallVertexList&, std::mt19937&)>;
 
         /**
          * Problem-specific palns params.
@@ -75,7 +75,7 @@ namespace op {
             }
 
             if(params->repair.intermediate_infeasible && params->repair.use_2opt_before_restoring_feasibility) {
-                solution.tour.do_2opt();
+                solution.do_2opt();
             }
 
             solution.make_travel_time_feasible();